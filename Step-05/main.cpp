@@ -108,7 +108,7 @@ OperationHoursMeter::OperationHoursMeter()
     : days_{}
     , hours_{days_}
     , minutes_{hours_}
-    , seconds_{minutes_}
+    , seconds_{static_cast<I_Incrementable&>(minutes_)} // NOT the copy-c'tor!
     , sec_10th_{seconds_}
 {}
 
@@ -0,0 +1,376 @@
+/*
+ * ===============================================================
+ * Consuming Counter Chains via C++20 Coroutines
+ * ===============================================================
+ * This version is basically the same as the prior one but adds
+ * two coroutine based ways to drive and observe counter chains:
+ *
+ *  - `Generator<T>` turns a chain into a lazily evaluated stream
+ *    of states, optionally only yielding when a chosen stage (or
+ *    any stage above it) has changed, so a sticky chain that has
+ *    reached its limit does not produce any more values;
+ *
+ *  - `TickLoop` is a single threaded event loop that resumes any
+ *    number of `Task`-coroutines when their next tick deadline
+ *    has come, so many meters with different periods and phases
+ *    can be ticked WITHOUT a sleeping thread for each of them.
+ *
+ *   +----------+  co_await  +----------+ resume() at +----------+
+ *   | Task     |----------->| TickLoop |------------>| Task     |
+ *   | (meter 1)| until(t1)  |----------|  earliest   | (meter 1)|
+ *   +----------+            | queue_   |  deadline   +----------+
+ *   +----------+  co_await  | (sorted  |             +----------+
+ *   | Task     |----------->|  by time)|------------>| Task     |
+ *   | (meter n)| until(tn)  +----------+             | (meter n)|
+ *   +----------+                                     +----------+
+*/
+#include <climits>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+template<typename T>
+class Generator {
+public:
+    struct promise_type {
+        T current_{};
+        std::exception_ptr error_{};
+        Generator get_return_object() {
+            return Generator{handle_type::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T value) {
+            current_ = std::move(value);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error_ = std::current_exception(); }
+    };
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        iterator() =default;
+        explicit iterator(handle_type h) : h_{h} { advance(); }
+        T const& operator*() const { return h_.promise().current_; }
+        T const* operator->() const { return &h_.promise().current_; }
+        iterator& operator++() { advance(); return *this; }
+        void operator++(int) { advance(); }
+        bool operator==(std::default_sentinel_t) const {
+            return !h_ || h_.done();
+        }
+    private:
+        void advance() {
+            h_.resume();
+            if (h_.done() && h_.promise().error_)
+                std::rethrow_exception(h_.promise().error_);
+        }
+        handle_type h_{};
+    };
+
+    Generator(Generator&& rhs) noexcept
+        : h_{std::exchange(rhs.h_, {})}
+    {}
+    Generator& operator=(Generator rhs) noexcept {
+        std::swap(h_, rhs.h_);
+        return *this;
+    }
+    ~Generator() { if (h_) h_.destroy(); }
+    iterator begin() { return iterator{h_}; }
+    std::default_sentinel_t end() const { return {}; }
+private:
+    explicit Generator(handle_type h) : h_{h} {}
+    handle_type h_;
+};
+
+#include <chrono>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() {
+            return Task{handle_type::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+    using handle_type = std::coroutine_handle<promise_type>;
+    Task(Task&& rhs) noexcept
+        : h_{std::exchange(rhs.h_, {})}
+    {}
+    Task& operator=(Task&&) =delete;
+    ~Task() { if (h_) h_.destroy(); }
+    handle_type handle() const { return h_; }
+private:
+    explicit Task(handle_type h) : h_{h} {}
+    handle_type h_;
+};
+
+class TickLoop {
+public:
+    using clock = std::chrono::steady_clock;
+    class Awaiter {
+    public:
+        Awaiter(TickLoop& loop, clock::time_point deadline)
+            : loop_{loop}, deadline_{deadline}
+        {}
+        bool await_ready() const { return deadline_ <= clock::now(); }
+        void await_suspend(std::coroutine_handle<> h) {
+            loop_.schedule(deadline_, h);
+        }
+        void await_resume() const {}
+    private:
+        TickLoop& loop_;
+        clock::time_point deadline_;
+    };
+    Awaiter until(clock::time_point deadline) { return {*this, deadline}; }
+    void spawn(Task task);
+    void run();
+    unsigned long long get_wakeups() const { return wakeups_; }
+private:
+    struct Entry {
+        clock::time_point deadline;
+        unsigned long long seq;
+        std::coroutine_handle<> h;
+        bool operator>(Entry const& rhs) const {
+            return (deadline != rhs.deadline) ? (deadline > rhs.deadline)
+                                              : (seq > rhs.seq);
+        }
+    };
+    void schedule(clock::time_point deadline, std::coroutine_handle<> h) {
+        queue_.push({deadline, seq_++, h});
+    }
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue_;
+    std::vector<Task> tasks_;
+    unsigned long long seq_ = 0;
+    unsigned long long wakeups_ = 0;
+};
+
+void TickLoop::spawn(Task task) {
+    schedule(clock::now(), task.handle());
+    tasks_.push_back(std::move(task));
+}
+
+void TickLoop::run() {
+    while (!queue_.empty()) {
+        auto const deadline = queue_.top().deadline;
+        if (deadline > clock::now()) {
+            std::this_thread::sleep_until(deadline);
+            ++wakeups_;
+        }
+        // resume EVERYTHING that is due now in one go, so a single
+        // wakeup serves all meters sharing (nearly) the same phase
+        auto const now = clock::now();
+        while (!queue_.empty() && queue_.top().deadline <= now) {
+            auto const h = queue_.top().h;
+            queue_.pop();
+            h.resume();
+        }
+    }
+    tasks_.clear();
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <iostream>
+#include <string>
+
+struct UpperLower {
+    int upper;
+    int lower;
+};
+
+Generator<UpperLower> counter_chain_states(int n) {
+    FlexCounter<int, 3> upper{[]{ return true; }};
+    FlexCounter<int, 7> lower{[&upper]{ return upper.incr(); }};
+    for (int i = 0; i < n; ++i) {
+        co_yield UpperLower{upper.get_value(), lower.get_value()};
+        lower.incr();
+    }
+}
+
+void test_counter_chain(int n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    for (auto const& s : counter_chain_states(n)) {
+        auto const space_or_nl = (s.lower+1 != 7) ? ' ' : '\n';
+        std::cout << s.upper << '/' << s.lower << space_or_nl;
+    }
+    std::cout << std::endl;
+}
+
+class HhmmssChain {
+public:
+    enum class Stage { hh, mm, ss };
+    struct State {
+        int hh, mm, ss;
+        bool operator==(State const&) const =default;
+    };
+    HhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    HhmmssChain(HhmmssChain const&) =delete;
+    HhmmssChain& operator=(HhmmssChain const&) =delete;
+    bool incr() { return ss.incr(); }
+    State get_state() const {
+        return {hh.get_value(), mm.get_value(), ss.get_value()};
+    }
+    std::string to_string() const;
+private:
+    FlexCounter<int, 24> hh;
+    FlexCounter<int, 60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{[this]{ return mm.incr(); }};
+};
+
+std::string HhmmssChain::to_string() const {
+    std::string result;
+    if (hh.get_value() < 10) result += "0";
+    result += std::to_string(hh.get_value());
+    result += ":";
+    if (mm.get_value() < 10) result += "0";
+    result += std::to_string(mm.get_value());
+    result += ":";
+    if (ss.get_value() < 10) result += "0";
+    result += std::to_string(ss.get_value());
+    return result;
+}
+
+// Yields the state after each of `n` increments of `chain`, but
+// only if `watch` or any stage above it has changed -- ie. with
+// `Stage::ss` every change is reported (a saturated sticky chain
+// is silent), with `Stage::mm` only the minute boundaries etc.
+Generator<HhmmssChain::State>
+chain_states(HhmmssChain& chain, int n,
+             HhmmssChain::Stage watch = HhmmssChain::Stage::ss) {
+    using Stage = HhmmssChain::Stage;
+    auto prev = chain.get_state();
+    for (int i = 0; i < n; ++i) {
+        chain.incr();
+        auto const curr = chain.get_state();
+        bool const changed =
+               (curr.hh != prev.hh)
+            || (watch != Stage::hh && curr.mm != prev.mm)
+            || (watch == Stage::ss && curr.ss != prev.ss);
+        prev = curr;
+        if (changed)
+            co_yield curr;
+    }
+}
+
+void test_hhmmss_states(int n1, int n2) {
+    std::cout << "==== " << __func__ << " ====" << std::endl;
+    HhmmssChain resetting_hhmmss{true};
+    HhmmssChain sticky_hhmmss{false};
+    for (int i = 0; i < n1-n2; ++i) {
+        resetting_hhmmss.incr();
+        sticky_hhmmss.incr();
+    }
+    int resetting_count = 0;
+    for (auto const& s : chain_states(resetting_hhmmss, 2*n2)) {
+        (void)s;
+        ++resetting_count;
+    }
+    int sticky_count = 0;
+    for (auto const& s : chain_states(sticky_hhmmss, 2*n2)) {
+        (void)s;
+        ++sticky_count;
+    }
+    std::cout << "resetting: " << resetting_count << " states, now at "
+              << resetting_hhmmss.to_string() << '\n'
+              << "sticky:    " << sticky_count << " states, now at "
+              << sticky_hhmmss.to_string() << std::endl;
+    HhmmssChain minutes_only{true};
+    std::cout << "minute boundaries within 5 min:";
+    for (auto const& s : chain_states(minutes_only, 5*60,
+                                      HhmmssChain::Stage::mm))
+        std::cout << ' ' << s.hh << ':' << s.mm << ':' << s.ss;
+    std::cout << std::endl;
+}
+
+Task drive_meter(TickLoop& loop, HhmmssChain& chain,
+                 TickLoop::clock::duration period,
+                 TickLoop::clock::duration phase,
+                 int ticks) {
+    auto deadline = TickLoop::clock::now() + phase;
+    for (int i = 0; i < ticks; ++i) {
+        co_await loop.until(deadline);
+        chain.incr();
+        deadline += period;
+    }
+}
+
+#include <deque>
+
+void test_tick_loop(int meters, int ticks) {
+    std::cout << "==== " << __func__ << " ====" << std::endl;
+    using namespace std::chrono_literals;
+    std::deque<HhmmssChain> chains{};
+    TickLoop loop{};
+    auto const start = TickLoop::clock::now();
+    for (int i = 0; i < meters; ++i) {
+        auto& chain = chains.emplace_back(true);
+        auto const period = 1ms * (1 + i % 3);
+        auto const phase = 100us * (i % 7);
+        loop.spawn(drive_meter(loop, chain, period, phase, ticks));
+    }
+    loop.run();
+    auto const elapsed = std::chrono::duration_cast<
+        std::chrono::milliseconds>(TickLoop::clock::now() - start);
+    bool all_ok = true;
+    for (auto const& chain : chains)
+        all_ok = all_ok && (chain.get_state().ss == ticks % 60);
+    std::cout << meters << " meters ticked " << ticks << " times each"
+              << " by one thread with " << loop.get_wakeups()
+              << " wakeups in " << elapsed.count() << "ms: "
+              << (all_ok ? "OK" : "MISMATCH") << std::endl;
+}
+
+int main() {
+    test_counter_chain(25);
+    test_hhmmss_states(24*60*60, 333);
+    test_tick_loop(3000, 50);
+}
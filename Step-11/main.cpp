@@ -0,0 +1,1674 @@
+/*
+ * ===============================================================
+ * Differential Validation of Counter Engines
+ * ===============================================================
+ * All prior Steps implement the same observable behaviour with
+ * different techniques. Here copies of all of them up to Step-09
+ * (each in a namespace named after its Step; Step-10 only adds
+ * coroutines to Step-09's chain) are driven side by side by
+ * a `DiffHarness` with IDENTICAL tick sequences and compared to
+ * a purely arithmetic reference model after each operation:
+ *
+ *   +-----------+           +----------------+
+ *   | Sequence  | n ticks   |  DiffHarness   |  get_state()
+ *   |-----------|---------->|----------------|---------> ==?
+ *   | random    |           | Reference      |      (all equal
+ *   | boundary  |           | Engine 1       |       to the
+ *   | long run  |           | ...            |       reference)
+ *   | bulk jump |           | Engine n       |
+ *   +-----------+           +----------------+
+ *
+ * An engine MAY provide `advance(n)` to apply `n` ticks at once,
+ * otherwise the harness calls `incr()` `n` times. Besides the
+ * days/hours/minutes/seconds/tenths meters also the 24h chains of
+ * Step-08 and Step-09 are checked, resetting and sticky
+ * (`HhmmssChain{false}`), and a throwing chain made from Step-09's
+ * FlexCounter. The result of each single increment (counted,
+ * refused, threw) is compared too and each run goes past 23:59:59
+ * at least once.
+*/
+#include <climits>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+struct DhmsState {
+    unsigned long long days;
+    unsigned hh, mm, ss, tenth;
+};
+
+bool operator==(DhmsState const& lhs, DhmsState const& rhs) {
+    return lhs.days == rhs.days && lhs.hh == rhs.hh && lhs.mm == rhs.mm
+        && lhs.ss == rhs.ss && lhs.tenth == rhs.tenth;
+}
+
+std::string to_string(DhmsState const& s) {
+    auto two = [](unsigned v) {
+        return std::string(v < 10 ? "0" : "") + std::to_string(v);
+    };
+    return std::to_string(s.days) + 'd' + two(s.hh) + ':' + two(s.mm)
+         + ':' + two(s.ss) + '.' + std::to_string(s.tenth);
+}
+
+struct HmsState {
+    int hh, mm, ss;
+};
+
+bool operator==(HmsState const& lhs, HmsState const& rhs) {
+    return lhs.hh == rhs.hh && lhs.mm == rhs.mm && lhs.ss == rhs.ss;
+}
+
+std::string to_string(HmsState const& s) {
+    auto two = [](int v) {
+        return std::string(v < 10 ? "0" : "") + std::to_string(v);
+    };
+    return two(s.hh) + ':' + two(s.mm) + ':' + two(s.ss);
+}
+
+// what happened to a sequence of increments: how many of them
+// were counted, refused (sticky) or thrown at (throwing)
+struct Tally {
+    unsigned long long counted = 0;
+    unsigned long long refused = 0;
+    unsigned long long threw = 0;
+};
+
+bool operator==(Tally const& lhs, Tally const& rhs) {
+    return lhs.counted == rhs.counted && lhs.refused == rhs.refused
+        && lhs.threw == rhs.threw;
+}
+
+// ---------------------------------------------------------------
+// reference models: the expected observable behaviour computed
+// from the total number of ticks with plain arithmetic
+
+class DhmsReference {
+public:
+    static char const* name() { return "reference"; }
+    Tally advance(unsigned long long n) { total_ += n; return {n, 0, 0}; }
+    unsigned long long get_total() const { return total_; }
+    DhmsState get_state() const {
+        return {total_ / (24*60*60*10),
+                unsigned(total_ % (24*60*60*10) / (60*60*10)),
+                unsigned(total_ % (60*60*10) / (60*10)),
+                unsigned(total_ % (60*10) / 10),
+                unsigned(total_ % 10)};
+    }
+private:
+    unsigned long long total_ = 0;
+};
+
+class HmsReference {
+public:
+    enum Mode { resetting, sticky, throwing };
+    static constexpr unsigned long long LAST = 24*60*60 - 1;
+    explicit HmsReference(Mode mode) : mode_{mode} {}
+    static char const* name() { return "reference"; }
+    Tally advance(unsigned long long n);
+    unsigned long long get_total() const { return total_; }
+    HmsState get_state() const {
+        auto const t = total_ % (LAST + 1);
+        return {int(t / 3600), int(t % 3600 / 60), int(t % 60)};
+    }
+private:
+    Mode const mode_;
+    unsigned long long total_ = 0;
+};
+
+Tally HmsReference::advance(unsigned long long n) {
+    if (mode_ == resetting) {
+        total_ += n;
+        return {n, 0, 0};
+    }
+    auto const room = LAST - total_;
+    auto const counted = (n < room) ? n : room;
+    total_ += counted;
+    if (mode_ == sticky)
+        return {counted, n - counted, 0};
+    return {counted, 0, n - counted};
+}
+
+// ---------------------------------------------------------------
+// engines under test: copied VERBATIM from the respective Steps
+// (their #includes moved to the top), only with the added members
+// `name()` and `get_state()` (marked as such) to make them
+// observable, plus two NEW engines marked as such
+
+namespace step00 {
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-00"; }
+    DhmsState get_state() const {
+        return {value_ / (24*60*60*10),
+                unsigned(value_ % (24*60*60*10) / (60*60*10)),
+                unsigned(value_ % (60*60*10) / (60*10)),
+                unsigned(value_ % (60*10) / 10),
+                unsigned(value_ % 10)};
+    }
+    OperationHoursMeter() =default;
+    std::string to_string() const;
+    void incr() { ++value_; }
+private:
+    unsigned long long value_{};
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << value_ / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value_ % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value_ % 10);
+    return os.str();
+}
+
+// a NEW engine: same representation but with bulk advance
+class BulkOperationHoursMeter {
+public:
+    static char const* name() { return "Step-00+advance"; }
+    void incr() { ++value_; }
+    Tally advance(unsigned long long n) { value_ += n; return {n, 0, 0}; }
+    DhmsState get_state() const {
+        return {value_ / (24*60*60*10),
+                unsigned(value_ % (24*60*60*10) / (60*60*10)),
+                unsigned(value_ % (60*60*10) / (60*10)),
+                unsigned(value_ % (60*10) / 10),
+                unsigned(value_ % 10)};
+    }
+private:
+    unsigned long long value_{};
+};
+
+} // namespace step00
+
+namespace step01 {
+
+// shows a countdown in
+// - days,
+// - hours,
+// - minutes,
+// - seconds, and
+// - and tenth of a second
+
+class ChainableCounter {
+public:
+    ChainableCounter() =default;
+    ChainableCounter(unsigned limit, ChainableCounter* next)
+        : limit_{limit}, next_{next}
+    {}
+    unsigned get_value() const { return value_; }
+    unsigned get_limit() const { return limit_; }
+    void incr();
+private:
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+    ChainableCounter* const next_ = nullptr;
+};
+
+void ChainableCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        if (next_) next_->incr();
+    }
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-01"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr() { sec_10th_.incr();  }
+private:
+    ChainableCounter days_;
+    ChainableCounter hours_;
+    ChainableCounter minutes_;
+    ChainableCounter seconds_;
+    ChainableCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, &days_}
+    , minutes_{60, &hours_}
+    , seconds_{60, &minutes_}
+    , sec_10th_{10, &seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+} // namespace step01
+
+namespace step02 {
+
+class LimitCounter {
+public:
+    LimitCounter() =default;
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {}
+    unsigned get_value() const { return value_; }
+    unsigned get_limit() const { return limit_; }
+    virtual void incr();
+private:
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+};
+
+void LimitCounter::incr() {
+    if (++value_ == limit_)
+        value_ = 0;
+}
+
+class OverflowCounter : public LimitCounter {
+public:
+    OverflowCounter(unsigned limit, LimitCounter& next)
+        : LimitCounter{limit}, next_{next}
+    {}
+    void incr() override;
+private:
+    LimitCounter& next_;
+};
+
+void OverflowCounter::incr() {
+    LimitCounter::incr();
+    if (get_value() == 0)
+        next_.incr();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-02"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    LimitCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, days_}
+    , minutes_{60, hours_}
+    , seconds_{60, minutes_}
+    , sec_10th_{10, seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step02
+
+namespace step03 {
+
+class LimitCounter {
+public:
+    LimitCounter() =default;
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {}
+    unsigned get_value() const { return value_; }
+    unsigned get_limit() const { return limit_; }
+    void incr();
+private:
+    virtual void overflowed() { /*empty*/ }
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+};
+
+void LimitCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        overflowed();
+    }
+}
+
+class OverflowCounter : public LimitCounter {
+public:
+    OverflowCounter(unsigned limit, LimitCounter& next)
+        : LimitCounter{limit}, next_{next}
+    {}
+private:
+    void overflowed() override;
+    LimitCounter& next_;
+};
+
+void OverflowCounter::overflowed() {
+    next_.incr();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-03"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    LimitCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, days_}
+    , minutes_{60, hours_}
+    , seconds_{60, minutes_}
+    , sec_10th_{10, seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step03
+
+namespace step04 {
+
+class I_Incrementable {
+public:
+    virtual ~I_Incrementable() =default;
+    virtual void incr() =0;
+};
+
+class BasicCounter : public I_Incrementable {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+private:
+    unsigned value_ = 0;
+};
+
+class LimitCounter : public I_Incrementable {
+public:
+    LimitCounter() =default;
+    unsigned get_value() const { return value_; }
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {}
+    unsigned get_limit() const { return limit_; }
+    void incr() override;
+private:
+    virtual void overflowed() { /*empty*/ }
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+};
+
+void LimitCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        overflowed();
+    }
+}
+
+class OverflowCounter : public LimitCounter {
+
+public:
+    OverflowCounter(unsigned limit, I_Incrementable& next)
+        : LimitCounter{limit}, next_{next}
+    {}
+private:
+    unsigned value_ = 0;
+    void overflowed() override;
+    I_Incrementable& next_;
+};
+
+void OverflowCounter::overflowed() {
+    next_.incr();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-04"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, days_}
+    , minutes_{60, hours_}
+    , seconds_{60, minutes_}
+    , sec_10th_{10, seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step04
+
+namespace step04x {
+
+class I_Incrementable
+{
+public:
+    virtual ~I_Incrementable() = default;
+    virtual void incr() = 0;
+};
+
+class BasicCounter : public I_Incrementable
+{
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+
+protected:
+    unsigned value_ = 0;
+};
+
+class LimitCounter : public BasicCounter
+{
+public:
+    LimitCounter() = default;
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {
+    }
+    unsigned get_limit() const { return limit_; }
+    void incr() override;
+
+private:
+    virtual void overflowed()
+    { /*empty*/
+    }
+    unsigned const limit_ = UINT_MAX;
+};
+
+void LimitCounter::incr()
+{
+    BasicCounter::incr();
+    if (get_value() >= limit_)
+    {
+        value_ = 0;
+        overflowed();
+    }
+}
+
+class OverflowCounter : public LimitCounter
+{
+
+public:
+    OverflowCounter(unsigned limit, I_Incrementable &next)
+        : LimitCounter{limit}, next_{next}
+    {
+    }
+
+private:
+    void overflowed() override;
+    I_Incrementable &next_;
+};
+
+void OverflowCounter::overflowed()
+{
+    next_.incr();
+}
+
+class OperationHoursMeter
+{
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-04x"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+
+private:
+    BasicCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}, hours_{24, days_}, minutes_{60, hours_}, seconds_{60, minutes_}, sec_10th_{10, seconds_}
+{
+}
+
+std::string OperationHoursMeter::to_string() const
+{
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr()
+{
+    sec_10th_.incr();
+}
+
+} // namespace step04x
+
+namespace step04y {
+
+class I_Incrementable {
+public:
+    virtual ~I_Incrementable() =default;
+    virtual void incr() =0;
+};
+
+class BasicCounter : public I_Incrementable {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+private:
+    unsigned value_ = 0;
+};
+
+class LimitCounter : public I_Incrementable {
+public:
+    LimitCounter() =default;
+    unsigned get_value() const { return value_; }
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {}
+    unsigned get_limit() const { return limit_; }
+    void incr() override;
+private:
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+};
+
+void LimitCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+    }
+}
+
+class OverflowCounter : public I_Incrementable {
+public:
+    OverflowCounter(unsigned limit, I_Incrementable& next)
+        : limit_{limit}, next_{next}
+    {}
+    unsigned get_value() const { return value_; }
+    virtual void incr();
+private:
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+    I_Incrementable& next_;
+};
+
+void OverflowCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        next_.incr();
+    }
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-04y"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, days_}
+    , minutes_{60, hours_}
+    , seconds_{60, minutes_}
+    , sec_10th_{10, seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step04y
+
+namespace step05 {
+
+class I_Incrementable {
+public:
+    virtual ~I_Incrementable() =default;
+    virtual void incr() =0;
+};
+
+class BasicCounter : public I_Incrementable {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public I_Incrementable {
+public:
+    LimitCounter() =default;
+    unsigned get_value() const { return value_; }
+    unsigned constexpr get_limit() { return limit_; }
+    void incr() override;
+private:
+    virtual void overflowed() { /*empty*/ }
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        overflowed();
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(I_Incrementable& next)
+        : LimitCounter<limit_>{}, next_{next}
+    {}
+private:
+    unsigned value_ = 0;
+    void overflowed() override;
+    I_Incrementable& next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    next_.incr();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-05"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{days_}
+    , minutes_{hours_}
+    , seconds_{static_cast<I_Incrementable&>(minutes_)} // NOT the copy-c'tor!
+    , sec_10th_{seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step05
+
+namespace step05x {
+
+class I_Incrementable
+{
+public:
+    virtual ~I_Incrementable() = default;
+    virtual void incr() = 0;
+};
+
+class BasicCounter : public I_Incrementable
+{
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+
+protected:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_>
+class LimitCounter : public BasicCounter
+{
+public:
+    LimitCounter() = default;
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr() override;
+
+private:
+    virtual void overflowed() { /*empty*/ }
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    BasicCounter::incr();
+    if (get_value() >= limit_) {
+        value_ = 0; overflowed();
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(I_Incrementable &next)
+        : LimitCounter<limit_>{}, next_{next}
+    {}
+
+private:
+    void overflowed() override;
+    I_Incrementable &next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    next_.incr();
+}
+
+class OperationHoursMeter
+{
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-05x"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{days_}
+    , minutes_{hours_}
+    , seconds_{static_cast<I_Incrementable&>(minutes_)} // NOT the copy-c'tor!
+    , sec_10th_{seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step05x
+
+namespace step05y {
+
+class I_Incrementable {
+public:
+    virtual ~I_Incrementable() =default;
+    virtual void incr() =0;
+};
+
+class BasicCounter : public I_Incrementable {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() override { ++value_; }
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public I_Incrementable {
+public:
+    LimitCounter() =default;
+    unsigned get_value() const { return value_; }
+    unsigned get_limit() const { return limit_; }
+    void incr() override;
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public I_Incrementable {
+public:
+    OverflowCounter(I_Incrementable& next)
+        : next_{next}
+    {}
+    unsigned get_value() const { return value_; }
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr() override;
+private:
+    unsigned value_ = 0;
+    I_Incrementable& next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        next_.incr();
+    }
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-05y"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{days_}
+    , minutes_{hours_}
+    , seconds_{static_cast<I_Incrementable&>(minutes_)} // NOT the copy-c'tor!
+    , sec_10th_{seconds_}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step05y
+
+namespace step06 {
+
+class BasicCounter {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() { ++value_; }
+    void reset() { value_ = 0;}
+private:
+    unsigned value_ = 0;
+};
+
+class LimitCounter : public BasicCounter {
+public:
+    LimitCounter();
+    LimitCounter(unsigned limit)
+        : limit_{limit}
+    {}
+    unsigned get_limit() const { return limit_; }
+    void incr();
+private:
+    unsigned const limit_ = UINT_MAX;
+    virtual void overflowed() { /*empty*/ }
+};
+
+void LimitCounter::incr() {
+    BasicCounter::incr();
+    if (get_value() == limit_) { // BasicCounter::get_value() ...
+        reset();                 // BasicCounter::reset()
+        overflowed();     // may be LimitCounter::overflowed()
+                          // -OR-   OverflowCounter::overflowed()
+    }
+}
+
+class OverflowCounter : public LimitCounter {
+public:
+    OverflowCounter(unsigned limit, std::function<void()> next)
+        : LimitCounter{limit}, next_{next}
+    {}
+private:
+    void overflowed() override;
+    std::function<void()> next_;
+};
+
+void OverflowCounter::overflowed() {
+    if (next_) next_();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-06"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter hours_;
+    OverflowCounter minutes_;
+    OverflowCounter seconds_;
+    OverflowCounter sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{24, [this]{ days_.incr(); }}
+    , minutes_{60, [this]{ hours_.incr(); }}
+    , seconds_{60, [this]{ minutes_.incr(); }}
+    , sec_10th_{10, [this]{ seconds_.incr(); }}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step06
+
+namespace step07 {
+
+class BasicCounter {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() { ++value_; }
+    void reset() { value_ = 0;}
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public BasicCounter {
+public:
+    LimitCounter() =default;
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr();
+private:
+    virtual void overflowed() { /*empty*/ }
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    BasicCounter::incr();
+    if (get_value() == limit_) { // BasicCounter::get_value() ...
+        reset();                 // BasicCounter::reset()
+        overflowed();     // may be LimitCounter::overflowed()
+                          // -OR-   OverflowCounter::overflowed()
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(std::function<void()> next)
+        : next_{next}
+    {}
+private:
+    void overflowed() override;
+    std::function<void()> next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    if (next_) next_();
+}
+
+class OperationHoursMeter {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-07"; }
+    DhmsState get_state() const {
+        return {days_.get_value(), hours_.get_value(),
+                minutes_.get_value(), seconds_.get_value(),
+                sec_10th_.get_value()};
+    }
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{[this]{ days_.incr(); }}
+    , minutes_{[this]{ hours_.incr(); }}
+    , seconds_{[this]{ minutes_.incr(); }}
+    , sec_10th_{[this]{ seconds_.incr(); }}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+} // namespace step07
+
+namespace step08 {
+
+template<unsigned N = UINT_MAX>
+class FlexCounter {
+public:
+    static const unsigned MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    unsigned get_value() const { return value_; }
+    bool incr();
+private:
+    unsigned value_ = 0;
+    std::function<bool()> next_;
+};
+
+template<unsigned N>
+bool FlexCounter<N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = 0;
+        return true;
+    }
+    return false;
+}
+
+class HhmmssChain {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-08"; }
+    HmsState get_state() const {
+        return {int(hh.get_value()), int(mm.get_value()), int(ss.get_value())};
+    }
+    HhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    void incr() { ss.incr(); }
+    std::string to_string() const;
+private:
+    FlexCounter<24> hh;
+    FlexCounter<60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<60> ss{[this]{ return mm.incr(); }};
+};
+
+} // namespace step08
+
+namespace step09 {
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+class HhmmssChain {
+public:
+    // added: to make it observable by the harness
+    static char const* name() { return "Step-09"; }
+    HmsState get_state() const {
+        return {int(hh.get_value()), int(mm.get_value()), int(ss.get_value())};
+    }
+    HhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    void incr() { ss.incr(); }
+    std::string to_string() const;
+private:
+    FlexCounter<int, 24> hh;
+    FlexCounter<int, 60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{[this]{ return mm.incr(); }};
+};
+
+std::string HhmmssChain::to_string() const {
+    std::string result;
+    if (hh.get_value() < 10) result += "0";
+    result += std::to_string(hh.get_value());
+    result += ":";
+    if (mm.get_value() < 10) result += "0";
+    result += std::to_string(mm.get_value());
+    result += ":";
+    if (ss.get_value() < 10) result += "0";
+    result += std::to_string(ss.get_value());
+    return result;
+}
+
+// a NEW engine: Step-09 throws only from a single FlexCounter, so
+// this chain is built like HhmmssChain but with a throwing top
+class ThrowingHhmmss {
+public:
+    static char const* name() { return "Step-09 FlexCounter, throwing"; }
+    bool incr() { return ss.incr(); }
+    HmsState get_state() const {
+        return {hh.get_value(), mm.get_value(), ss.get_value()};
+    }
+private:
+    FlexCounter<int, 24> hh{[]()-> bool { throw 42; }};
+    FlexCounter<int, 60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{[this]{ return mm.incr(); }};
+};
+
+} // namespace step09
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: the harness cross-checking them
+
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// The 24h chains of Step-08/09 start resetting (`true`) or sticky
+// (`false`) and return nothing from `incr()`: an increment that did
+// not change the state was refused.
+template<typename Chain, bool top>
+class ObservedChain {
+public:
+    static char const* name() {
+        static std::string const name = std::string{Chain::name()}
+                                      + (top ? " resetting" : " sticky");
+        return name.c_str();
+    }
+    bool incr() {
+        auto const before = chain_.get_state();
+        chain_.incr();
+        return !(chain_.get_state() == before);
+    }
+    HmsState get_state() const { return chain_.get_state(); }
+private:
+    Chain chain_{top};
+};
+
+template<typename E, typename = void>
+struct has_advance : std::false_type {};
+template<typename E>
+struct has_advance<E, std::void_t<decltype(std::declval<E&>().advance(1ull))>>
+    : std::true_type {};
+
+template<typename E>
+void tick_once(E& engine, Tally& tally) {
+    if constexpr (std::is_void_v<decltype(engine.incr())>) {
+        engine.incr();
+        ++tally.counted;
+    }
+    else {
+        try {
+            if (engine.incr()) ++tally.counted;
+            else ++tally.refused;
+        }
+        catch (...) {
+            ++tally.threw;
+        }
+    }
+}
+
+template<typename E>
+Tally apply_ticks(E& engine, unsigned long long n) {
+    if constexpr (has_advance<E>::value) {
+        return engine.advance(n);
+    }
+    else {
+        Tally tally{};
+        for (; n > 0; --n)
+            tick_once(engine, tally);
+        return tally;
+    }
+}
+
+// Drives a reference model and any number of engines with the
+// same operations. Each operation is a number of ticks; after it
+// the observable state and tally of every engine must be equal
+// to those of the reference. The first difference is reported.
+template<typename Reference, typename... Engines>
+class DiffHarness {
+public:
+    template<typename... Args>
+    explicit DiffHarness(Args&&... args)
+        : reference_{std::forward<Args>(args)...}
+    {}
+    DiffHarness(DiffHarness const&) =delete;
+    DiffHarness& operator=(DiffHarness const&) =delete;
+    bool apply(unsigned long long n);
+    Reference const& reference() const { return reference_; }
+    unsigned long long get_ops() const { return ops_; }
+    Tally const& get_tally() const { return tally_; }
+private:
+    template<typename E>
+    bool check(E const& engine, Tally const& tally,
+               Tally const& expected, unsigned long long n) const;
+    Reference reference_;
+    std::tuple<Engines...> engines_{};
+    unsigned long long ops_ = 0;
+    Tally tally_{};                 // expected, over all operations
+};
+
+template<typename Reference, typename... Engines>
+bool DiffHarness<Reference, Engines...>::apply(unsigned long long n) {
+    ++ops_;
+    auto const expected = reference_.advance(n);
+    tally_.counted += expected.counted;
+    tally_.refused += expected.refused;
+    tally_.threw += expected.threw;
+    return std::apply([&](auto&... engine) {
+        return (check(engine, apply_ticks(engine, n), expected, n) && ...);
+    }, engines_);
+}
+
+template<typename Reference, typename... Engines>
+template<typename E>
+bool DiffHarness<Reference, Engines...>::check(
+        E const& engine, Tally const& tally,
+        Tally const& expected, unsigned long long n) const {
+    if (engine.get_state() == reference_.get_state() && tally == expected)
+        return true;
+    std::cout << "\n!!! MISMATCH in " << E::name()
+              << " at operation #" << ops_ << " (+" << n << " ticks,"
+              << " total " << reference_.get_total() << ")\n"
+              << "    expected " << to_string(reference_.get_state())
+              << " [" << expected.counted << '/' << expected.refused
+              << '/' << expected.threw << "]\n"
+              << "    actual   " << to_string(engine.get_state())
+              << " [" << tally.counted << '/' << tally.refused
+              << '/' << tally.threw << ']' << std::endl;
+    return false;
+}
+
+// ---------------------------------------------------------------
+// tick sequences
+
+// number of ticks from `total` to the next multiple of `period`
+unsigned long long to_boundary(unsigned long long total,
+                               unsigned long long period) {
+    return period - total % period;
+}
+
+template<typename Harness>
+bool run_random(Harness& h, std::mt19937_64& rng, unsigned long long ops) {
+    std::uniform_int_distribution<int> kind{0, 9};
+    std::uniform_int_distribution<unsigned long long> bulk{2, 2000};
+    for (unsigned long long i = 0; i < ops; ++i)
+        if (!h.apply(kind(rng) < 8 ? 1 : bulk(rng)))
+            return false;
+    return true;
+}
+
+// approach stage boundaries up to a few ticks before them and
+// then cross them with single ticks (each one at least once, so
+// also the top one, eg. from 23:59:57 on for a 24h chain)
+template<typename Harness>
+bool run_boundary_bursts(Harness& h, std::mt19937_64& rng,
+                         std::vector<unsigned long long> const& periods,
+                         unsigned long long rounds) {
+    std::uniform_int_distribution<unsigned long long> pick{0, periods.size()-1};
+    std::uniform_int_distribution<unsigned long long> before{1, 3};
+    for (unsigned long long r = 0; r < rounds; ++r) {
+        auto const period = (r < periods.size()) ? periods[r]
+                                                 : periods[pick(rng)];
+        auto const ahead = before(rng);
+        auto const gap = to_boundary(h.reference().get_total(), period);
+        if (gap > ahead && !h.apply(gap - ahead))
+            return false;
+        for (auto i = 0ull; i < 2*ahead; ++i)
+            if (!h.apply(1)) return false;
+    }
+    return true;
+}
+
+template<typename Harness>
+bool run_long(Harness& h, unsigned long long ticks) {
+    for (; ticks > 0; --ticks)
+        if (!h.apply(1)) return false;
+    return true;
+}
+
+template<typename Harness>
+bool run_bulk_jumps(Harness& h, std::mt19937_64& rng,
+                    unsigned long long ops, unsigned long long max_jump) {
+    std::uniform_int_distribution<unsigned long long> jump{1, max_jump};
+    for (unsigned long long i = 0; i < ops; ++i)
+        if (!h.apply(jump(rng))) return false;
+    return true;
+}
+
+#include <chrono>
+
+template<typename Harness>
+bool run_all(char const* title, Harness& h, std::mt19937_64& rng,
+             std::vector<unsigned long long> const& periods,
+             unsigned long long scale) {
+    auto const start = std::chrono::steady_clock::now();
+    // the long run spans more than the top period, so it crosses
+    // (or runs into) the top boundary tick by tick at least once
+    auto const top = periods.back() + periods.front();
+    bool const ok = run_random(h, rng, 2*scale)
+                 && run_boundary_bursts(h, rng, periods,
+                                        periods.size() + scale/100)
+                 && run_long(h, (4*scale > top) ? 4*scale : top)
+                 && run_bulk_jumps(h, rng, scale/1000, 100'000);
+    std::chrono::duration<double> const secs =
+        std::chrono::steady_clock::now() - start;
+    auto const& tally = h.get_tally();
+    auto const ticks = tally.counted + tally.refused + tally.threw;
+    std::cout << title << ": " << (ok ? "OK" : "FAILED") << " after "
+              << h.get_ops() << " operations, "
+              << ticks << " ticks per engine (" << tally.refused
+              << " refused, " << tally.threw << " threw), "
+              << static_cast<unsigned long long>(ticks / secs.count() * 60)
+              << " ticks/min per engine" << std::endl;
+    return ok;
+}
+
+// deliberately broken engine to prove mismatches are detected
+struct OffByOneMeter : step00::OperationHoursMeter {
+    static char const* name() { return "off-by-one"; }
+    DhmsState get_state() const {
+        auto s = OperationHoursMeter::get_state();
+        if (s.hh == 13 && s.mm == 0 && s.ss == 0 && s.tenth == 0)
+            s.hh = 12;
+        return s;
+    }
+};
+
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    auto const scale = (argc > 1) ? std::strtoull(argv[1], nullptr, 10)
+                                  : 200'000ull;
+    auto const seed = (argc > 2) ? std::strtoull(argv[2], nullptr, 10)
+                                 : std::random_device{}();
+    std::cout << "scale " << scale << ", seed " << seed << std::endl;
+    std::mt19937_64 rng{seed};
+    std::vector<unsigned long long> const dhms_periods{
+        10, 60*10, 60*60*10, 24*60*60*10};
+    std::vector<unsigned long long> const hms_periods{
+        60, 60*60, 24*60*60};
+
+    DiffHarness<DhmsReference,
+                step00::OperationHoursMeter,
+                step00::BulkOperationHoursMeter,
+                step01::OperationHoursMeter,
+                step02::OperationHoursMeter,
+                step03::OperationHoursMeter,
+                step04::OperationHoursMeter,
+                step04x::OperationHoursMeter,
+                step04y::OperationHoursMeter,
+                step05::OperationHoursMeter,
+                step05x::OperationHoursMeter,
+                step05y::OperationHoursMeter,
+                step06::OperationHoursMeter,
+                step07::OperationHoursMeter> dhms{};
+    DiffHarness<HmsReference, ObservedChain<step08::HhmmssChain, true>,
+                              ObservedChain<step09::HhmmssChain, true>>
+        resetting{HmsReference::resetting};
+    DiffHarness<HmsReference, ObservedChain<step08::HhmmssChain, false>,
+                              ObservedChain<step09::HhmmssChain, false>>
+        sticky{HmsReference::sticky};
+    DiffHarness<HmsReference, step09::ThrowingHhmmss>
+        throwing{HmsReference::throwing};
+    bool ok = run_all("dhms meters", dhms, rng, dhms_periods, scale);
+    ok = run_all("resetting hhmmss", resetting, rng, hms_periods, scale) && ok;
+    ok = run_all("sticky hhmmss", sticky, rng, hms_periods, scale/10) && ok;
+    ok = run_all("throwing hhmmss", throwing, rng, hms_periods, scale/1000) && ok;
+    // the top boundary must have been hit, not just approached
+    bool const saturated = sticky.get_tally().refused > 0
+                        && throwing.get_tally().threw > 0;
+    std::cout << "sticky/throwing past 23:59:59: "
+              << (saturated ? "checked" : "NOT REACHED") << std::endl;
+
+    DiffHarness<DhmsReference, OffByOneMeter> broken{};
+    bool const caught = !run_long(broken, 2*60*60*10 * 24);
+    std::cout << "self check: broken engine "
+              << (caught ? "detected" : "NOT DETECTED") << std::endl;
+    return (ok && saturated && caught) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,315 @@
+/*
+ * ===============================================================
+ * Runtime Limits with Precomputed Reciprocals
+ * ===============================================================
+ * This version is basically the same as Step-01 (limits are held
+ * in data members, ie. known at runtime only) but each stage can
+ * now also be advanced by MANY ticks at once, for which the sum
+ * of value and ticks needs to be split into a carry and the new
+ * value. As the limit is no compile time constant, the compiler
+ * cannot replace `/` and `%` by a multiplication, so a `Divisor`
+ * does it instead, with a reciprocal computed ONCE in its ctor:
+ *
+ *            +------------------+
+ *     +----->| ChainableCounter |
+ *     | 0..1 |------------------|       +-----------------+
+ *     |      | value_           |       |     Divisor     |
+ *     |      | limit_           |<>---->|-----------------|
+ *     +------| div_             |       | d_, m_, sh1_,   |
+ *      next_ |------------------|       | sh2_            |
+ *            | incr()           |       |-----------------|
+ *            | advance(n)       |       | div(n), mod(n)  |
+ *            +------------------+       +-----------------+
+ *
+ * The reciprocal follows T. Granlund, P. Montgomery: "Division by
+ * Invariant Integers using Multiplication" (PLDI 1994, Fig. 4.1),
+ * which is proven to give the exact quotient for ALL 64-bit
+ * dividends and ALL divisors 1 <= d < 2^64 (Theorem 4.2):
+ *
+ *   l   = ceil(log2(d))
+ *   m'  = floor(2^64 * (2^l - d) / d) + 1        (fits 64 bits)
+ *   t1  = mulhi(m', n)
+ *   q   = (t1 + ((n - t1) >> min(l,1))) >> max(l-1,0)
+ *
+ * so a quotient costs one multiplication, an addition, a
+ * subtraction and two shifts, the remainder another multiply.
+*/
+
+#include <cassert>
+#include <climits>
+#include <cstdint>
+
+class Divisor {
+public:
+    explicit Divisor(std::uint64_t d);
+    std::uint64_t get_divisor() const { return d_; }
+    std::uint64_t div(std::uint64_t n) const {
+        auto const t1 = static_cast<std::uint64_t>(
+            (static_cast<unsigned __int128>(m_) * n) >> 64);
+        return (t1 + ((n - t1) >> sh1_)) >> sh2_;
+    }
+    std::uint64_t mod(std::uint64_t n) const { return n - div(n) * d_; }
+private:
+    std::uint64_t d_;
+    std::uint64_t m_;
+    unsigned char sh1_;
+    unsigned char sh2_;
+};
+
+Divisor::Divisor(std::uint64_t d)
+    : d_{d}
+{
+    assert(d != 0);
+    unsigned l = 0;
+    while (l < 64 && (std::uint64_t{1} << l) < d)
+        ++l;
+    auto const two_l = static_cast<unsigned __int128>(1) << l;
+    m_ = static_cast<std::uint64_t>(((two_l - d) << 64) / d + 1);
+    sh1_ = (l < 1) ? l : 1;
+    sh2_ = (l < 1) ? 0 : l - 1;
+}
+
+class ChainableCounter {
+public:
+    ChainableCounter() =default;
+    ChainableCounter(unsigned limit, ChainableCounter* next)
+        : limit_{limit}, div_{limit}, next_{next}
+    {}
+    unsigned get_value() const { return value_; }
+    unsigned get_limit() const { return limit_; }
+    void incr();
+    void advance(unsigned long long n);
+private:
+    unsigned value_ = 0;
+    unsigned const limit_ = UINT_MAX;
+    Divisor const div_{UINT_MAX};
+    ChainableCounter* const next_ = nullptr;
+};
+
+void ChainableCounter::incr() {
+    if (++value_ == limit_) {
+        value_ = 0;
+        if (next_) next_->incr();
+    }
+}
+
+void ChainableCounter::advance(unsigned long long n) {
+    if (n < limit_ - value_) {         // fast path: no carry
+        value_ += static_cast<unsigned>(n);
+        return;
+    }
+    // value_ + n may exceed 64 bit, so split n first
+    auto const carry = div_.div(n);
+    auto const rest = static_cast<unsigned>(n - carry * limit_);
+    auto const sum = value_ + static_cast<unsigned long long>(rest);
+    auto const wrap = (sum >= limit_);
+    value_ = static_cast<unsigned>(wrap ? sum - limit_ : sum);
+    if (next_) next_->advance(carry + wrap);
+}
+
+// above: helper class to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from that class
+
+#include <initializer_list>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// a meter with customer defined limits for the two middle stages,
+// eg. 60min * 8h for the operation hours within a working shift
+class ShiftHoursMeter {
+public:
+    ShiftHoursMeter(unsigned minutes_per_hour, unsigned hours_per_shift);
+    std::string to_string() const;
+    void incr() { sec_10th_.incr(); }
+    void advance(unsigned long long n) { sec_10th_.advance(n); }
+private:
+    ChainableCounter shifts_;
+    ChainableCounter hours_;
+    ChainableCounter minutes_;
+    ChainableCounter seconds_;
+    ChainableCounter sec_10th_;
+};
+
+ShiftHoursMeter::ShiftHoursMeter(unsigned minutes_per_hour,
+                                 unsigned hours_per_shift)
+    : shifts_{}
+    , hours_{hours_per_shift, &shifts_}
+    , minutes_{minutes_per_hour, &hours_}
+    , seconds_{60, &minutes_}
+    , sec_10th_{10, &seconds_}
+{}
+
+std::string ShiftHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << shifts_.get_value()
+       << 's'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+// splits a tick total into stages given as runtime radix list
+// (lowest stage first) with the reciprocals computed only once
+class RadixDecomposer {
+public:
+    static constexpr unsigned MAX_RADICES = 8;
+    RadixDecomposer(std::initializer_list<unsigned> radices) {
+        if (radices.size() > MAX_RADICES)
+            throw std::invalid_argument{"more than 8 radices"};
+        for (auto r : radices) divs_[n_++] = Divisor{r};
+    }
+    // fills `out[0..size()]`, the topmost (unlimited) stage last
+    void decompose(unsigned long long total, unsigned long long* out) const {
+        for (unsigned i = 0; i < n_; ++i) {
+            auto const q = divs_[i].div(total);
+            out[i] = total - q * divs_[i].get_divisor();
+            total = q;
+        }
+        out[n_] = total;
+    }
+    unsigned size() const { return n_ + 1; }
+private:
+    Divisor divs_[MAX_RADICES]{Divisor{1}, Divisor{1}, Divisor{1}, Divisor{1},
+                     Divisor{1}, Divisor{1}, Divisor{1}, Divisor{1}};
+    unsigned n_ = 0;
+};
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+bool check_divisor(std::uint64_t d, std::mt19937_64& rng) {
+    Divisor const div{d};
+    auto ok = [&](std::uint64_t n) {
+        return div.div(n) == n / d && div.mod(n) == n % d;
+    };
+    // all dividends around multiples of d (where a reciprocal that
+    // is too small or too large would first show), near the top
+    // of the 32 and 64 bit ranges, and random ones
+    for (std::uint64_t k = 0; k < (1u << 12); ++k) {
+        auto const n = k * d;
+        if (!ok(n) || !ok(n - 1) || !ok(n + 1)) return false;
+    }
+    for (std::uint64_t n : {std::uint64_t{UINT_MAX}, ~std::uint64_t{0}})
+        for (std::uint64_t i = 0; i < 4096; ++i)
+            if (!ok(n - i)) return false;
+    for (int i = 0; i < 10'000; ++i)
+        if (!ok(rng()) || !ok(rng() >> (rng() % 64))) return false;
+    return true;
+}
+
+void test_divisors(std::uint64_t exhaustive_limit) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937_64 rng{42};
+    std::vector<std::uint64_t> divisors{};
+    for (std::uint64_t d = 1; d <= 1000; ++d)
+        divisors.push_back(d);
+    for (int s = 10; s < 64; ++s) {
+        auto const p = std::uint64_t{1} << s;
+        for (auto d : {p - 1, p, p + 1}) divisors.push_back(d);
+    }
+    divisors.push_back(~std::uint64_t{0});
+    for (int i = 0; i < 100; ++i)
+        divisors.push_back(rng() | 1);
+    unsigned failed = 0;
+    for (auto d : divisors)
+        if (!check_divisor(d, rng)) {
+            std::cout << "FAILED for divisor " << d << std::endl;
+            ++failed;
+        }
+    std::cout << divisors.size() << " divisors checked, "
+              << failed << " failed" << std::endl;
+    // exhaustive up to the given limit for the typical radices
+    for (std::uint64_t d : {10u, 24u, 60u}) {
+        Divisor const div{d};
+        std::uint64_t errors = 0;
+        for (std::uint64_t n = 0; n <= exhaustive_limit; ++n)
+            errors += (div.div(n) != n / d);
+        std::cout << "exhaustive check for " << d << " up to "
+                  << exhaustive_limit << ": " << errors << " errors"
+                  << std::endl;
+    }
+}
+
+void test_shift_meter(unsigned mph, unsigned hps) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    ShiftHoursMeter bulk{mph, hps};
+    ShiftHoursMeter single{mph, hps};
+    std::mt19937_64 rng{4711};
+    std::uniform_int_distribution<unsigned long long> jump{0, 100'000};
+    for (int i = 0; i < 100; ++i) {
+        auto const n = jump(rng);
+        bulk.advance(n);
+        for (auto k = 0ull; k < n; ++k) single.incr();
+    }
+    std::cout << bulk.to_string() << " (bulk) vs. "
+              << single.to_string() << " (single) "
+              << (bulk.to_string() == single.to_string() ? "OK" : "MISMATCH")
+              << std::endl;
+    ShiftHoursMeter huge{mph, hps};
+    huge.advance(~0ull);
+    std::cout << "after 2^64-1 ticks: " << huge.to_string() << std::endl;
+}
+
+void benchmark_decompose(unsigned r0, unsigned r1, unsigned r2, unsigned r3) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937_64 rng{1};
+    std::vector<unsigned long long> totals(10'000'000);
+    for (auto& t : totals) t = rng() >> 20;
+    unsigned long long const radices[] = {r0, r1, r2, r3};
+    RadixDecomposer const dec{r0, r1, r2, r3};
+    unsigned long long out[5];
+    unsigned long long check_hw = 0, check_rc = 0;
+    using clock = std::chrono::steady_clock;
+    auto const t0 = clock::now();
+    for (auto total : totals) {
+        for (auto r : radices) {
+            check_hw += total % r;
+            total /= r;
+        }
+        check_hw += total;
+    }
+    auto const t1 = clock::now();
+    for (auto total : totals) {
+        dec.decompose(total, out);
+        for (unsigned i = 0; i < dec.size(); ++i) check_rc += out[i];
+    }
+    auto const t2 = clock::now();
+    using ms = std::chrono::milliseconds;
+    std::cout << totals.size() << " totals, hardware div: "
+              << std::chrono::duration_cast<ms>(t1 - t0).count() << "ms, "
+              << "reciprocals: "
+              << std::chrono::duration_cast<ms>(t2 - t1).count() << "ms "
+              << (check_hw == check_rc ? "(same results)" : "(MISMATCH)")
+              << std::endl;
+    try {
+        RadixDecomposer const too_long{2, 2, 2, 2, 2, 2, 2, 2, 2};
+        std::cout << "9 radices accepted (WRONG)" << std::endl;
+    }
+    catch (std::invalid_argument const& e) {
+        std::cout << "9 radices rejected: " << e.what() << std::endl;
+    }
+}
+
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    // limits from the command line so the compiler CANNOT know them
+    auto const mph = (argc > 1) ? unsigned(std::atoi(argv[1])) : 60u;
+    auto const hps = (argc > 2) ? unsigned(std::atoi(argv[2])) : 8u;
+    // pass "-x" as third argument for the full 32-bit range (slow)
+    auto const full = (argc > 3) && std::string{argv[3]} == "-x";
+    test_divisors(full ? UINT_MAX : (1u << 26));
+    test_shift_meter(mph, hps);
+    benchmark_decompose(10, 60, mph, hps);
+}
@@ -0,0 +1,317 @@
+/*
+ * ===============================================================
+ * Batched Conversion of Tick Totals into Stages and Text
+ * ===============================================================
+ * Step-00 keeps a single `unsigned long long` per meter, which is
+ * the cheapest possible state to update, but converting it back
+ * into days, hours, minutes, seconds and tenths costs a chain of
+ * divisions for EACH meter. Here many totals are converted in one
+ * go, into one column (array) per stage, and optionally into
+ * fixed width text records:
+ *
+ *   totals[]        +------------------+    days[]  hh[]  mm[] ...
+ *   +---+---+---+   |   TickColumns    |    +---+  +---+ +---+
+ *   | t0| t1| t2|-->|------------------|--->|d0 |  |h0 | |m0 |
+ *   +---+---+---+   | decompose(...)   |    |d1 |  |h1 | |m1 |
+ *    (4 per AVX2    | render_fixed(...)|    +---+  +---+ +---+
+ *     register)     +------------------+
+ *
+ *  - days = t / 864000 is calculated in double precision (exact
+ *    for t < 2^51, corrected by at most one afterwards);
+ *
+ *  - the remainder within a day is < 2^20, so each further stage
+ *    is split off with a single 32x32->64 bit multiply and shift
+ *    per lane (`_mm256_mul_epu32`), with reciprocals that are
+ *    verified at compile time to be exact for the value range
+ *    each stage can see.
+ *
+ * Without AVX2 (or for totals >= 2^51) the same multiply-shift
+ * arithmetic runs lane by lane.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Division by `D` for any `r <= RMAX` via `(r * M) >> K`. With
+// M = ceil(2^K/D) = (2^K + e)/D, 0 <= e < D, the error r*e/(D*2^K)
+// stays below the 1/D gap to the next quotient if RMAX*D <= 2^K.
+template<std::uint32_t D, std::uint32_t RMAX>
+struct StageDivisor {
+    static constexpr unsigned shift() {
+        unsigned k = 0;
+        while ((std::uint64_t{1} << k) < std::uint64_t{RMAX} * D) ++k;
+        return k;
+    }
+    static constexpr unsigned K = shift();
+    static constexpr std::uint64_t M = ((std::uint64_t{1} << K) + D - 1) / D;
+    static_assert(M <= UINT32_MAX, "reciprocal must fit 32 bits");
+    static_assert(std::uint64_t{RMAX} * M < (std::uint64_t{1} << 63),
+                  "product must fit 64 bits");
+    static std::uint32_t div(std::uint32_t r) {
+        return static_cast<std::uint32_t>((r * M) >> K);
+    }
+};
+
+constexpr std::uint64_t TICKS_PER_DAY = 24*60*60*10;
+
+using HourDiv = StageDivisor<60*60*10, TICKS_PER_DAY - 1>;
+using MinuteDiv = StageDivisor<60*10, 60*60*10 - 1>;
+using SecondDiv = StageDivisor<10, 60*10 - 1>;
+
+class TickColumns {
+public:
+    static constexpr std::size_t RECORD = 22; // "DDDDDDDDDDdHH:MM:SS.t\n"
+    void decompose(std::uint64_t const* totals, std::size_t n);
+    std::size_t render_fixed(char* buffer) const;
+    std::size_t size() const { return days.size(); }
+    std::vector<std::uint64_t> days;
+    std::vector<std::uint32_t> hh, mm, ss, tenth;
+private:
+    void decompose_one(std::size_t i, std::uint64_t total);
+    void decompose_four(std::size_t i, std::uint64_t const* totals);
+};
+
+inline void TickColumns::decompose_one(std::size_t i, std::uint64_t total) {
+    days[i] = total / TICKS_PER_DAY;
+    auto r = static_cast<std::uint32_t>(total - days[i] * TICKS_PER_DAY);
+    hh[i] = HourDiv::div(r);     r -= hh[i] * (60*60*10);
+    mm[i] = MinuteDiv::div(r);   r -= mm[i] * (60*10);
+    ss[i] = SecondDiv::div(r);   r -= ss[i] * 10;
+    tenth[i] = r;
+}
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace {
+
+// 4 x 64 bit lanes holding values < 2^32 -> 4 x 32 bit stored
+inline void store_low32(std::uint32_t* dst, __m256i v) {
+    auto const idx = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+    auto const packed = _mm256_permutevar8x32_epi32(v, idx);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm256_castsi256_si128(packed));
+}
+
+template<typename Div>
+inline __m256i split_stage(__m256i& r, std::uint32_t d) {
+    auto const q = _mm256_srli_epi64(
+        _mm256_mul_epu32(r, _mm256_set1_epi64x(Div::M)), Div::K);
+    r = _mm256_sub_epi64(r, _mm256_mul_epu32(q, _mm256_set1_epi64x(d)));
+    return q;
+}
+
+} // namespace
+
+inline void TickColumns::decompose_four(std::size_t i,
+                                        std::uint64_t const* totals) {
+    auto const t = _mm256_loadu_si256(
+        reinterpret_cast<__m256i const*>(totals + i));
+    if (!_mm256_testz_si256(t, _mm256_set1_epi64x(~((1ll << 51) - 1)))) {
+        for (std::size_t k = 0; k < 4; ++k)
+            decompose_one(i + k, totals[i + k]);
+        return;
+    }
+    // exact u64 -> double for values < 2^52 via the exponent bits
+    auto const magic_bits = _mm256_set1_epi64x(0x4330000000000000);
+    auto const magic = _mm256_set1_pd(4503599627370496.0); // 2^52
+    auto const x = _mm256_sub_pd(
+        _mm256_castsi256_pd(_mm256_or_si256(t, magic_bits)), magic);
+    auto const per_day = _mm256_set1_pd(double(TICKS_PER_DAY));
+    auto d = _mm256_floor_pd(
+        _mm256_mul_pd(x, _mm256_set1_pd(1.0 / TICKS_PER_DAY)));
+    auto rd = _mm256_sub_pd(x, _mm256_mul_pd(d, per_day)); // exact
+    auto const one = _mm256_set1_pd(1.0);
+    auto const too_big = _mm256_cmp_pd(rd, per_day, _CMP_GE_OQ);
+    d = _mm256_add_pd(d, _mm256_and_pd(too_big, one));
+    rd = _mm256_sub_pd(rd, _mm256_and_pd(too_big, per_day));
+    auto const too_small = _mm256_cmp_pd(rd, _mm256_setzero_pd(), _CMP_LT_OQ);
+    d = _mm256_sub_pd(d, _mm256_and_pd(too_small, one));
+    rd = _mm256_add_pd(rd, _mm256_and_pd(too_small, per_day));
+    auto const days_u64 = _mm256_xor_si256(
+        _mm256_castpd_si256(_mm256_add_pd(d, magic)), magic_bits);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&days[i]), days_u64);
+
+    auto r = _mm256_cvtepu32_epi64(_mm256_cvttpd_epi32(rd));
+    store_low32(&hh[i], split_stage<HourDiv>(r, 60*60*10));
+    store_low32(&mm[i], split_stage<MinuteDiv>(r, 60*10));
+    store_low32(&ss[i], split_stage<SecondDiv>(r, 10));
+    store_low32(&tenth[i], r);
+}
+#else
+inline void TickColumns::decompose_four(std::size_t i,
+                                        std::uint64_t const* totals) {
+    for (std::size_t k = 0; k < 4; ++k)
+        decompose_one(i + k, totals[i + k]);
+}
+#endif
+
+void TickColumns::decompose(std::uint64_t const* totals, std::size_t n) {
+    days.resize(n);
+    hh.resize(n); mm.resize(n); ss.resize(n); tenth.resize(n);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        decompose_four(i, totals);
+    for (; i < n; ++i)
+        decompose_one(i, totals[i]);
+}
+
+namespace {
+
+struct DigitPairs {
+    char pairs[200];
+    constexpr DigitPairs() : pairs{} {
+        for (int i = 0; i < 100; ++i) {
+            pairs[2*i] = char('0' + i / 10);
+            pairs[2*i + 1] = char('0' + i % 10);
+        }
+    }
+};
+constexpr DigitPairs digit_pairs{};
+
+inline void put2(char* p, std::uint32_t v) {
+    p[0] = digit_pairs.pairs[2*v];
+    p[1] = digit_pairs.pairs[2*v + 1];
+}
+
+} // namespace
+
+// Writes `size()` records of exactly RECORD bytes into `buffer`,
+// days right aligned in 10 columns ('#'-filled if too wide).
+std::size_t TickColumns::render_fixed(char* buffer) const {
+    char* p = buffer;
+    for (std::size_t i = 0; i < size(); ++i, p += RECORD) {
+        auto d = days[i];
+        if (d < 10'000'000'000ull) {
+            int k = 9;
+            do { p[k--] = char('0' + d % 10); d /= 10; } while (d && k >= 0);
+            while (k >= 0) p[k--] = ' ';
+        }
+        else {
+            for (int k = 0; k < 10; ++k) p[k] = '#';
+        }
+        p[10] = 'd';
+        put2(p + 11, hh[i]);
+        p[13] = ':';
+        put2(p + 14, mm[i]);
+        p[16] = ':';
+        put2(p + 17, ss[i]);
+        p[19] = '.';
+        p[20] = char('0' + tenth[i]);
+        p[21] = '\n';
+    }
+    return size_t(p - buffer);
+}
+
+// above: helper classes to convert MANY meters at once
+// ---------------------------------------------------------------
+// below: the Step-00 meter as reference and comparison
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    OperationHoursMeter() =default;
+    explicit OperationHoursMeter(unsigned long long value)
+        : value_{value}
+    {}
+    std::string to_string() const;
+    void incr() { ++value_; }
+    unsigned long long get_total() const { return value_; }
+private:
+    unsigned long long value_{};
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << value_ / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value_ % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value_ % 10);
+    return os.str();
+}
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+void test_decompose() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937_64 rng{7};
+    std::vector<std::uint64_t> totals{};
+    for (std::uint64_t d : {0ull, 1ull, 2ull, 99999ull, 3000000ull})
+        for (std::uint64_t r = 0; r < TICKS_PER_DAY; ++r)
+            totals.push_back(d * TICKS_PER_DAY + r);
+    for (int s = 0; s < 64; ++s)
+        for (int k = -3; k <= 3; ++k)
+            totals.push_back((std::uint64_t{1} << s) + k);
+    totals.push_back(~std::uint64_t{0});
+    for (int i = 0; i < 1'000'000; ++i)
+        totals.push_back(rng() >> (rng() % 64));
+    TickColumns cols{};
+    cols.decompose(totals.data(), totals.size());
+    std::size_t errors = 0;
+    for (std::size_t i = 0; i < totals.size(); ++i) {
+        auto const t = totals[i];
+        errors += (cols.days[i] != t / TICKS_PER_DAY)
+               || (cols.hh[i] != t % TICKS_PER_DAY / (60*60*10))
+               || (cols.mm[i] != t % (60*60*10) / (60*10))
+               || (cols.ss[i] != t % (60*10) / 10)
+               || (cols.tenth[i] != t % 10);
+    }
+    std::cout << totals.size() << " totals decomposed, "
+              << errors << " errors" << std::endl;
+}
+
+void benchmark_export(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937_64 rng{1};
+    std::vector<OperationHoursMeter> meters{};
+    meters.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        meters.emplace_back(rng() % (TICKS_PER_DAY * 100'000));
+    using clock = std::chrono::steady_clock;
+    using ms = std::chrono::milliseconds;
+
+    auto const t0 = clock::now();
+    std::size_t len_str = 0;
+    for (auto const& m : meters)
+        len_str += m.to_string().size() + 1;
+    auto const t1 = clock::now();
+
+    std::vector<std::uint64_t> totals(n);
+    for (std::size_t i = 0; i < n; ++i)
+        totals[i] = meters[i].get_total();
+    TickColumns cols{};
+    cols.decompose(totals.data(), n);
+    auto const t2 = clock::now();
+    std::vector<char> text(n * TickColumns::RECORD);
+    auto const len_fixed = cols.render_fixed(text.data());
+    auto const t3 = clock::now();
+
+    std::cout << n << " meters via to_string(): "
+              << std::chrono::duration_cast<ms>(t1 - t0).count() << "ms ("
+              << len_str << " bytes)\n"
+              << n << " meters batched: decompose "
+              << std::chrono::duration_cast<ms>(t2 - t1).count() << "ms"
+              << ", render "
+              << std::chrono::duration_cast<ms>(t3 - t2).count() << "ms ("
+              << len_fixed << " bytes)" << std::endl;
+    std::cout << "first records:\n"
+              << std::string(text.data(), 3 * TickColumns::RECORD)
+              << "first to_string(): " << meters[0].to_string() << std::endl;
+}
+
+int main() {
+    test_decompose();
+    benchmark_export(2'000'000);
+}
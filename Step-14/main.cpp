@@ -0,0 +1,287 @@
+/*
+ * ===============================================================
+ * Rendering Many Meters with Few System Calls
+ * ===============================================================
+ * All prior Steps print each meter with `std::cout << ... <<
+ * std::flush`, ie. with (at least) one `write` system call for
+ * EVERY single item. Here a `BatchWriter` renders the meters
+ * directly into a set of reusable chunks and hands all filled
+ * chunks to the kernel with ONE `writev` call once a configurable
+ * threshold is reached:
+ *
+ *   meter.render(p)     +----------------------------+
+ *   ------------------->| BatchWriter                |
+ *      (into reserved   |----------------------------|   writev()
+ *       space, no       | chunk 0 [##########]       |----------->
+ *       temporaries)    | chunk 1 [######    ]       |    fd
+ *                       | chunk 2 [          ] ...   | (no iostream
+ *                       | flush_threshold            |  involved)
+ *                       +----------------------------+
+ *
+ * The chunks are allocated once and reused after each flush, so
+ * in the steady state no heap allocation takes place either.
+*/
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <sys/uio.h>
+#include <unistd.h>
+
+class BatchWriter {
+public:
+    struct Config {
+        std::size_t chunk_size = 64 * 1024;
+        std::size_t chunks = 16;
+        std::size_t flush_threshold = 512 * 1024;
+    };
+    explicit BatchWriter(int fd) : BatchWriter{fd, Config{}} {}
+    BatchWriter(int fd, Config const& config);
+    BatchWriter(BatchWriter const&) =delete;
+    BatchWriter& operator=(BatchWriter const&) =delete;
+    ~BatchWriter();
+    // space for at least `n` bytes (n <= chunk_size) ...
+    char* reserve(std::size_t n);
+    // ... of which the first `n` are now filled
+    void commit(std::size_t n);
+    template<typename Render>
+    void emit(std::size_t max_len, Render render) {
+        commit(render(reserve(max_len)));
+    }
+    void write(std::string_view text);
+    void flush();
+    unsigned long long get_syscalls() const { return syscalls_; }
+    unsigned long long get_bytes() const { return bytes_; }
+private:
+    std::size_t pending() const {
+        return current_ * config_.chunk_size + fill_[current_];
+    }
+    int const fd_;
+    Config const config_;
+    std::vector<char> storage_;
+    std::vector<std::size_t> fill_;
+    std::vector<iovec> iov_;
+    std::size_t current_ = 0;
+    unsigned long long syscalls_ = 0;
+    unsigned long long bytes_ = 0;
+};
+
+BatchWriter::BatchWriter(int fd, Config const& config)
+    : fd_{fd}
+    , config_{config}
+    , storage_(config.chunk_size * config.chunks)
+    , fill_(config.chunks)
+    , iov_(config.chunks)
+{}
+
+BatchWriter::~BatchWriter() {
+    try { flush(); } catch (...) { /* nowhere to report it */ }
+}
+
+char* BatchWriter::reserve(std::size_t n) {
+    if (config_.chunk_size - fill_[current_] < n) {
+        if (current_ + 1 == config_.chunks)
+            flush();
+        else
+            ++current_;
+    }
+    return &storage_[current_ * config_.chunk_size + fill_[current_]];
+}
+
+void BatchWriter::commit(std::size_t n) {
+    fill_[current_] += n;
+    if (pending() >= config_.flush_threshold)
+        flush();
+}
+
+void BatchWriter::write(std::string_view text) {
+    while (!text.empty()) {
+        auto const n = (text.size() < config_.chunk_size)
+                     ? text.size() : config_.chunk_size;
+        auto* const p = reserve(n);
+        text.copy(p, n);
+        commit(n);
+        text.remove_prefix(n);
+    }
+}
+
+void BatchWriter::flush() {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i <= current_; ++i)
+        if (fill_[i] > 0)
+            iov_[count++] = {&storage_[i * config_.chunk_size], fill_[i]};
+    iovec* iov = iov_.data();
+    while (count > 0) {
+        auto const batch = (count < IOV_MAX) ? count : std::size_t{IOV_MAX};
+        auto const written = ::writev(fd_, iov, int(batch));
+        ++syscalls_;
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error{errno, std::generic_category(), "writev"};
+        }
+        bytes_ += std::size_t(written);
+        // skip what was completely written, adjust a partial write
+        for (auto rest = std::size_t(written); rest > 0; ) {
+            if (rest >= iov->iov_len) {
+                rest -= iov->iov_len;
+                ++iov; --count;
+            }
+            else {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + rest;
+                iov->iov_len -= rest;
+                rest = 0;
+            }
+        }
+    }
+    for (std::size_t i = 0; i <= current_; ++i)
+        fill_[i] = 0;
+    current_ = 0;
+}
+
+// above: helper class to output MANY meters efficiently
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of meter rendering into such output
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    static constexpr std::size_t MAX_TEXT = 20 + 11;
+    OperationHoursMeter() =default;
+    explicit OperationHoursMeter(unsigned long long value)
+        : value_{value}
+    {}
+    std::string to_string() const;
+    std::size_t render(char* out) const;
+    void incr() { ++value_; }
+private:
+    unsigned long long value_{};
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << value_ / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value_ % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value_ % 10);
+    return os.str();
+}
+
+// same format as `to_string()` but written into `out` (which must
+// have room for MAX_TEXT chars), returns the number of chars
+std::size_t OperationHoursMeter::render(char* out) const {
+    char digits[20];
+    auto days = value_ / (24*60*60*10);
+    int n = 0;
+    do { digits[n++] = char('0' + days % 10); days /= 10; } while (days);
+    char* p = out;
+    while (n > 0) *p++ = digits[--n];
+    auto const r = unsigned(value_ % (24*60*60*10));
+    auto two = [&p](unsigned v) {
+        *p++ = char('0' + v / 10);
+        *p++ = char('0' + v % 10);
+    };
+    *p++ = 'd';
+    two(r / (60*60*10));
+    *p++ = ':';
+    two(r % (60*60*10) / (60*10));
+    *p++ = ':';
+    two(r % (60*10) / 10);
+    *p++ = '.';
+    *p++ = char('0' + r % 10);
+    return std::size_t(p - out);
+}
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+std::vector<OperationHoursMeter> make_meters(std::size_t n) {
+    std::mt19937_64 rng{1};
+    std::vector<OperationHoursMeter> meters{};
+    meters.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        meters.emplace_back(rng() % (24*60*60*10ull * 100'000));
+    return meters;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void test_render() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::size_t errors = 0;
+    char buffer[OperationHoursMeter::MAX_TEXT];
+    for (auto const& m : make_meters(100'000))
+        errors += (m.to_string() != std::string(buffer, m.render(buffer)));
+    OperationHoursMeter const max{~0ull};
+    errors += (max.to_string() != std::string(buffer, max.render(buffer)));
+    std::cout << errors << " differences to to_string()" << std::endl;
+}
+
+void benchmark_dump(char const* path, std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    auto const meters = make_meters(n);
+    {
+        std::ofstream out{path};
+        auto const start = std::chrono::steady_clock::now();
+        for (auto const& m : meters)
+            out << m.to_string() << '\n' << std::flush;
+        std::cout << "ofstream + flush per meter: "
+                  << seconds_since(start) << "s, ~" << n
+                  << " syscalls" << std::endl;
+    }
+    std::string const expected = [path]{
+        std::ifstream in{path};
+        return std::string{std::istreambuf_iterator<char>{in}, {}};
+    }();
+    for (std::size_t threshold : {4096u, 64u * 1024, 1024u * 1024}) {
+        int const fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::system_error{errno, std::generic_category(), path};
+        auto const start = std::chrono::steady_clock::now();
+        unsigned long long syscalls;
+        {
+            BatchWriter::Config config{};
+            config.flush_threshold = threshold;
+            BatchWriter out{fd, config};
+            for (auto const& m : meters)
+                out.emit(OperationHoursMeter::MAX_TEXT + 1, [&m](char* p) {
+                    auto const len = m.render(p);
+                    p[len] = '\n';
+                    return len + 1;
+                });
+            out.flush();
+            syscalls = out.get_syscalls();
+        }
+        auto const secs = seconds_since(start);
+        ::close(fd);
+        std::ifstream in{path};
+        std::string const actual{std::istreambuf_iterator<char>{in}, {}};
+        std::cout << "BatchWriter, threshold " << std::setw(7) << threshold
+                  << ": " << secs << "s, " << syscalls << " syscalls"
+                  << (actual == expected ? "" : " - OUTPUT DIFFERS")
+                  << std::endl;
+    }
+    std::remove(path);
+}
+
+int main() {
+    test_render();
+    benchmark_dump("meters.log", 1'000'000);
+}
@@ -0,0 +1,311 @@
+/*
+ * ===============================================================
+ * Calendar Stages with Table Driven Variable Limits
+ * ===============================================================
+ * All prior Steps use a FIXED limit per stage, so counting could
+ * not go beyond days. Here the chain continues into months and
+ * years, where the limit of the day-of-month stage depends on the
+ * values of the stages ABOVE it (month and leap year). The limit
+ * is looked up in a precomputed table only when month or year
+ * change and cached, so each tick still only compares against
+ * one member, exactly like the fixed limit stages:
+ *
+ *   +------+   +-------+   +------------+   +----+   +----+
+ *   |year_ |<--|month_ |<--|day_        |<--|hh_ |<--... tenth_
+ *   +------+   +-------+   |day_limit_  |   +----+
+ *       :          :       +-----^------+
+ *       :          :             | looked up on month/year change
+ *       :          :       +------------------------------+
+ *       +..........+......>| CalendarTable (400 years)    |
+ *                          |  month_days[y%400][m]        |
+ *                          |  year_start[y%400]           |
+ *                          |  month_start[y%400][m]       |
+ *                          +------------------------------+
+ *
+ * As the Gregorian calendar repeats every 400 years (146097 days)
+ * the tables also allow a bulk `advance(n)` that skips whole
+ * cycles, years and months without looping over them.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+class CalendarTable {
+public:
+    static constexpr unsigned YEARS = 400;
+    static constexpr std::uint32_t CYCLE_DAYS = 146097;
+    constexpr CalendarTable();
+    // all `y` below are the year modulo 400
+    unsigned month_days(unsigned y, unsigned m) const { return month_days_[y][m]; }
+    std::uint32_t year_start(unsigned y) const { return year_start_[y]; }
+    unsigned month_start(unsigned y, unsigned m) const { return month_start_[y][m]; }
+    // day within 400 year cycle -> year in cycle, month, day (0-based)
+    void split(std::uint32_t day_in_cycle,
+               unsigned& y, unsigned& m, unsigned& d) const;
+private:
+    static constexpr bool is_leap(unsigned y) {
+        return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    }
+    std::uint8_t month_days_[YEARS][12];
+    std::uint16_t month_start_[YEARS][13];
+    std::uint32_t year_start_[YEARS + 1];
+};
+
+constexpr CalendarTable::CalendarTable()
+    : month_days_{}, month_start_{}, year_start_{}
+{
+    constexpr std::uint8_t normal[12] =
+        {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    for (unsigned y = 0; y < YEARS; ++y) {
+        unsigned doy = 0;
+        for (unsigned m = 0; m < 12; ++m) {
+            month_days_[y][m] = normal[m] + (m == 1 && is_leap(y));
+            month_start_[y][m] = std::uint16_t(doy);
+            doy += month_days_[y][m];
+        }
+        month_start_[y][12] = std::uint16_t(doy);
+        year_start_[y + 1] = year_start_[y] + doy;
+    }
+}
+
+void CalendarTable::split(std::uint32_t day_in_cycle,
+                          unsigned& y, unsigned& m, unsigned& d) const {
+    // a year has at least 365 days, so the estimate is never too
+    // small and needs at most one step back
+    y = std::min(day_in_cycle / 365, YEARS - 1);
+    while (year_start_[y] > day_in_cycle) --y;
+    auto const doy = day_in_cycle - year_start_[y];
+    m = std::min(doy / 31, 11u);
+    while (month_start_[y][m + 1] <= doy) ++m;
+    d = doy - month_start_[y][m];
+}
+
+constexpr CalendarTable calendar{};
+
+class CalendarMeter {
+public:
+    static constexpr std::uint64_t TICKS_PER_DAY = 24*60*60*10;
+    // the start date: `month` 1..12, `day` 1..days of that month
+    // (or std::invalid_argument is thrown)
+    CalendarMeter(unsigned year, unsigned month, unsigned day);
+    void incr();
+    void advance(std::uint64_t n);
+    unsigned long get_year() const { return year_; }
+    unsigned get_month() const { return month_ + 1; }
+    unsigned get_day() const { return day_ + 1; }
+    // number of month boundaries passed since the start
+    unsigned long elapsed_months() const;
+    std::string to_string() const;
+private:
+    void update_day_limit() {
+        day_limit_ = calendar.month_days(year_ % 400, month_);
+    }
+    void day_overflowed();
+    unsigned long const start_year_;
+    unsigned const start_month_;
+    unsigned long year_;
+    unsigned month_;
+    unsigned day_;
+    unsigned day_limit_;
+    unsigned hh_ = 0, mm_ = 0, ss_ = 0, tenth_ = 0;
+};
+
+CalendarMeter::CalendarMeter(unsigned year, unsigned month, unsigned day)
+    : start_year_{year}, start_month_{month - 1}
+    , year_{year}, month_{month - 1}, day_{day - 1}
+{
+    if (month < 1 || month > 12)
+        throw std::invalid_argument{"month not in 1..12"};
+    update_day_limit();
+    if (day < 1 || day > day_limit_)
+        throw std::invalid_argument{"day not in the month"};
+}
+
+void CalendarMeter::incr() {
+    if (++tenth_ < 10) return;
+    tenth_ = 0;
+    if (++ss_ < 60) return;
+    ss_ = 0;
+    if (++mm_ < 60) return;
+    mm_ = 0;
+    if (++hh_ < 24) return;
+    hh_ = 0;
+    if (++day_ < day_limit_) return;
+    day_overflowed();
+}
+
+void CalendarMeter::day_overflowed() {
+    day_ = 0;
+    if (++month_ == 12) {
+        month_ = 0;
+        ++year_;
+    }
+    update_day_limit();
+}
+
+void CalendarMeter::advance(std::uint64_t n) {
+    std::uint64_t const in_day =
+        ((hh_ * 60ull + mm_) * 60 + ss_) * 10 + tenth_;
+    auto const total = in_day + n % TICKS_PER_DAY;
+    auto days = n / TICKS_PER_DAY + total / TICKS_PER_DAY;
+    auto rest = unsigned(total % TICKS_PER_DAY);
+    tenth_ = rest % 10;  rest /= 10;
+    ss_ = rest % 60;     rest /= 60;
+    mm_ = rest % 60;     rest /= 60;
+    hh_ = rest;
+    if (days == 0) return;
+    if (days < day_limit_ - day_) {      // stays within the month
+        day_ += unsigned(days);
+        return;
+    }
+    auto const y400 = unsigned(year_ % 400);
+    days += calendar.year_start(y400)
+          + calendar.month_start(y400, month_) + day_;
+    unsigned y, m, d;
+    calendar.split(std::uint32_t(days % CalendarTable::CYCLE_DAYS), y, m, d);
+    year_ = (year_ - y400) + (days / CalendarTable::CYCLE_DAYS) * 400 + y;
+    month_ = m;
+    day_ = d;
+    update_day_limit();
+}
+
+unsigned long CalendarMeter::elapsed_months() const {
+    return (year_ - start_year_) * 12 + month_ - start_month_;
+}
+
+#include <iomanip>
+#include <sstream>
+
+std::string CalendarMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << std::setw(4) << year_
+       << '-'
+       << std::setw(2) << month_ + 1
+       << '-'
+       << std::setw(2) << day_ + 1
+       << ' '
+       << std::setw(2) << hh_
+       << ':'
+       << std::setw(2) << mm_
+       << ':'
+       << std::setw(2) << ss_
+       << '.'
+       << std::setw(1) << tenth_;
+    return os.str();
+}
+
+// above: helper classes to built calendar aware counters
+// ---------------------------------------------------------------
+// below: tests and a comparison with the fixed limit days counter
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// days since 1970-01-01 (H. Hinnant's `days_from_civil`) as an
+// INDEPENDENT reference for the table driven implementation
+long long days_from_civil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    auto const era = (y >= 0 ? y : y - 399) / 400;
+    auto const yoe = unsigned(y - era * 400);
+    auto const doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    auto const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+
+long long day_number(CalendarMeter const& m) {
+    return days_from_civil(m.get_year(), m.get_month(), m.get_day());
+}
+
+void test_calendar(std::uint64_t ticks) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    CalendarMeter single{2023, 12, 30};
+    CalendarMeter bulk{2023, 12, 30};
+    auto const start_day = day_number(single);
+    std::mt19937_64 rng{2024};
+    std::uniform_int_distribution<std::uint64_t> jump{1, 40 * 864000};
+    std::uint64_t done = 0, errors = 0;
+    while (done < ticks) {
+        auto const n = jump(rng);
+        for (auto k = 0ull; k < n; ++k) single.incr();
+        bulk.advance(n);
+        done += n;
+        errors += (single.to_string() != bulk.to_string())
+               || (day_number(bulk) - start_day != (long long)(done / 864000));
+    }
+    std::cout << "after " << done << " ticks: " << single.to_string()
+              << " / " << bulk.to_string() << ", " << errors
+              << " errors, " << bulk.elapsed_months()
+              << " months elapsed" << std::endl;
+
+    std::uint64_t big_errors = 0;
+    CalendarMeter far{2000, 2, 28};
+    auto const far_start = day_number(far);
+    std::uint64_t far_days = 0;
+    for (int i = 0; i < 100'000; ++i) {
+        auto const days = rng() % 1'000'000;
+        far.advance(days * 864000);
+        far_days += days;
+        big_errors += (day_number(far) - far_start != (long long)far_days);
+    }
+    std::cout << "after " << far_days << " days in big jumps: "
+              << far.to_string() << ", " << big_errors << " errors"
+              << std::endl;
+
+    for (auto const& date : {std::array<unsigned, 3>{2023, 0, 1},
+                             {2023, 13, 1}, {2023, 2, 29}, {2023, 4, 0}}) {
+        try { CalendarMeter{date[0], date[1], date[2]}; }
+        catch (std::invalid_argument const& ex) {
+            std::cout << date[0] << '-' << date[1] << '-' << date[2]
+                      << ": " << ex.what() << std::endl;
+        }
+    }
+    std::cout << "2024-2-29: " << CalendarMeter{2024, 2, 29}.to_string()
+              << std::endl;
+}
+
+// same carry logic as `CalendarMeter::incr()` with a constant
+// limit for the days and without months and years
+struct FixedDaysMeter {
+    void incr() {
+        if (++tenth_ < 10) return;
+        tenth_ = 0;
+        if (++ss_ < 60) return;
+        ss_ = 0;
+        if (++mm_ < 60) return;
+        mm_ = 0;
+        if (++hh_ < 24) return;
+        hh_ = 0;
+        ++days_;
+    }
+    unsigned long days_ = 0;
+    unsigned hh_ = 0, mm_ = 0, ss_ = 0, tenth_ = 0;
+};
+
+void benchmark_incr(unsigned long long n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    CalendarMeter meter{2024, 1, 1};
+    auto const t0 = clock::now();
+    for (auto i = 0ull; i < n; ++i) meter.incr();
+    auto const t1 = clock::now();
+    // the fixed limit counterpart: days as the top stage
+    FixedDaysMeter fixed{};
+    for (auto i = 0ull; i < n; ++i) fixed.incr();
+    auto const t2 = clock::now();
+    using ms = std::chrono::milliseconds;
+    std::cout << n << " ticks, calendar: "
+              << std::chrono::duration_cast<ms>(t1 - t0).count()
+              << "ms (" << meter.to_string() << "), fixed limits: "
+              << std::chrono::duration_cast<ms>(t2 - t1).count()
+              << "ms (" << fixed.days_ << "d)" << std::endl;
+}
+
+int main() {
+    test_calendar(500'000'000);
+    benchmark_incr(1'000'000'000);
+}
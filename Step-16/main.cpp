@@ -0,0 +1,233 @@
+/*
+ * ===============================================================
+ * Consistent Snapshots for Concurrent Readers via a Seqlock
+ * ===============================================================
+ * If a thread reads the stages of a chain while another thread
+ * is in the middle of a carry, it may see a TORN state, e.g. the
+ * seconds already reset to 00 but the minutes not yet advanced.
+ * Here all stages of a chain are guarded by a sequence counter
+ * (a "seqlock") that is odd while the single writer carries:
+ *
+ *        writer (one thread)              readers (any number)
+ *  --------------------------------   ---------------------------
+ *  seq_ : 2n      (even = stable)      s1 = seq_ (retry if odd)
+ *  no carry: store lowest stage only   copy all stages
+ *  carry:    seq_ = 2n+1               s2 = seq_
+ *            update several stages     s1 == s2 ? done : retry
+ *            seq_ = 2n+2
+ *
+ * Readers never block the writer. As a tick that does NOT carry
+ * changes a single stage with a single atomic store, only the
+ * (rare) carries bump the sequence counter, so that readers only
+ * need to retry if they overlap with one of those.
+*/
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+// Chain of stages with the given limits (lowest stage first),
+// where a limit of 0 means "unlimited" (only useful at the top).
+template<unsigned... Limits>
+class SeqlockChain {
+public:
+    static constexpr std::size_t N = sizeof...(Limits);
+    using Snapshot = std::array<unsigned, N>;
+    void incr();                               // ONE writer only
+    Snapshot read() const { unsigned long r; return read(r); }
+    Snapshot read(unsigned long& retries) const;
+    Snapshot read_unsynchronized() const;      // may be torn
+private:
+    static constexpr unsigned limits_[N] = {Limits...};
+    std::atomic<unsigned> seq_{0};
+    std::array<std::atomic<unsigned>, N> stage_{};
+};
+
+template<unsigned... Limits>
+void SeqlockChain<Limits...>::incr() {
+    auto const v0 = stage_[0].load(std::memory_order_relaxed) + 1;
+    if (v0 != limits_[0]) {
+        stage_[0].store(v0, std::memory_order_relaxed);
+        return;
+    }
+    auto const s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < N; ++i) {
+        auto const v = stage_[i].load(std::memory_order_relaxed) + 1;
+        if (v != limits_[i]) {
+            stage_[i].store(v, std::memory_order_relaxed);
+            break;
+        }
+        stage_[i].store(0, std::memory_order_relaxed);
+    }
+    seq_.store(s + 2, std::memory_order_release);
+}
+
+template<unsigned... Limits>
+auto SeqlockChain<Limits...>::read(unsigned long& retries) const
+        -> Snapshot {
+    Snapshot result;
+    retries = 0;
+    for (;; ++retries) {
+        if ((retries & 63) == 63)        // writer was likely preempted
+            std::this_thread::yield();   // while carrying
+        auto const s1 = seq_.load(std::memory_order_acquire);
+        if (s1 & 1) continue;
+        for (std::size_t i = 0; i < N; ++i)
+            result[i] = stage_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == s1)
+            return result;
+    }
+}
+
+template<unsigned... Limits>
+auto SeqlockChain<Limits...>::read_unsynchronized() const -> Snapshot {
+    Snapshot result;
+    for (std::size_t i = 0; i < N; ++i)
+        result[i] = stage_[i].load(std::memory_order_relaxed);
+    return result;
+}
+
+// above: helper class to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC types of counters built from that class
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    using Chain = SeqlockChain<10, 60, 60, 24, 0>;
+    void incr() { chain_.incr(); }
+    Chain::Snapshot snapshot(unsigned long& retries) const {
+        return chain_.read(retries);
+    }
+    Chain::Snapshot snapshot_unsynchronized() const {
+        return chain_.read_unsynchronized();
+    }
+    std::string to_string() const { return to_string(chain_.read()); }
+    static std::string to_string(Chain::Snapshot const& s);
+    static unsigned long long total(Chain::Snapshot const& s) {
+        return (((s[4] * 24ull + s[3]) * 60 + s[2]) * 60 + s[1]) * 10 + s[0];
+    }
+private:
+    Chain chain_;
+};
+
+std::string OperationHoursMeter::to_string(Chain::Snapshot const& s) {
+    std::ostringstream os{};
+    os.fill('0');
+    os << s[4]
+       << 'd'
+       << std::setw(2) << s[3]
+       << ':'
+       << std::setw(2) << s[2]
+       << ':'
+       << std::setw(2) << s[1]
+       << '.'
+       << std::setw(1) << s[0];
+    return os.str();
+}
+
+class HhmmssChain {                      // the resetting variant
+public:
+    using Chain = SeqlockChain<60, 60, 24>;
+    void incr() { chain_.incr(); }
+    std::string to_string() const;
+private:
+    Chain chain_;
+};
+
+std::string HhmmssChain::to_string() const {
+    auto const s = chain_.read();
+    std::ostringstream os{};
+    os.fill('0');
+    os << std::setw(2) << s[2]
+       << ':'
+       << std::setw(2) << s[1]
+       << ':'
+       << std::setw(2) << s[0];
+    return os.str();
+}
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct ReaderStats {
+    unsigned long long reads = 0;
+    unsigned long long retried_reads = 0;
+    unsigned long long retries = 0;
+    unsigned long long regressions = 0;      // impossible values seen
+    unsigned long long torn_regressions = 0; // ... when not using seq_
+};
+
+void benchmark_readers(unsigned readers, std::chrono::milliseconds duration) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    OperationHoursMeter meter{};
+    std::atomic<bool> stop{false};
+    std::vector<ReaderStats> stats(readers);
+    std::vector<std::thread> threads{};
+    for (unsigned r = 0; r < readers; ++r)
+        threads.emplace_back([&meter, &stop, &st = stats[r]]{
+            unsigned long long last = 0, last_torn = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                unsigned long retries;
+                auto const total = meter.total(meter.snapshot(retries));
+                st.regressions += (total < last);
+                last = total;
+                ++st.reads;
+                st.retried_reads += (retries > 0);
+                st.retries += retries;
+                auto const torn =
+                    meter.total(meter.snapshot_unsynchronized());
+                st.torn_regressions += (torn < last_torn);
+                last_torn = torn;
+            }
+        });
+    unsigned long long ticks = 0;
+    auto const end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+        for (int i = 0; i < 10'000; ++i, ++ticks)
+            meter.incr();
+    stop = true;
+    for (auto& t : threads) t.join();
+    ReaderStats sum{};
+    for (auto const& st : stats) {
+        sum.reads += st.reads;
+        sum.retried_reads += st.retried_reads;
+        sum.retries += st.retries;
+        sum.regressions += st.regressions;
+        sum.torn_regressions += st.torn_regressions;
+    }
+    std::cout << ticks << " ticks by 1 writer, now at "
+              << meter.to_string() << '\n'
+              << sum.reads << " snapshots by " << readers << " readers, "
+              << sum.retried_reads << " of them retried ("
+              << (sum.reads ? 100.0 * sum.retried_reads / sum.reads : 0.0)
+              << "%, " << sum.retries << " retries in total)\n"
+              << "impossible values: " << sum.regressions
+              << " with seqlock, " << sum.torn_regressions
+              << " when reading unsynchronized" << std::endl;
+}
+
+void test_hhmmss_chain() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    HhmmssChain chain{};
+    for (int i = 0; i < 24*60*60 - 1; ++i) chain.incr();
+    std::cout << chain.to_string();
+    chain.incr();
+    std::cout << " -> " << chain.to_string() << std::endl;
+}
+
+int main() {
+    test_hhmmss_chain();
+    auto const readers = std::max(2u, std::thread::hardware_concurrency() - 1);
+    benchmark_readers(readers, std::chrono::milliseconds{2000});
+}
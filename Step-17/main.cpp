@@ -0,0 +1,256 @@
+/*
+ * ===============================================================
+ * Rate and EWMA Gauges Updated at Stage Overflows
+ * ===============================================================
+ * This version is basically the same as Step-07 but any number of
+ * observers can be attached to each limited stage, which are run
+ * (after the carry to the next stage) exactly when that stage
+ * overflows. A `RateTracker` uses this to close a measurement
+ * window: it samples some event count, stores the count within
+ * the last window and updates an exponentially weighted moving
+ * average (EWMA) of it:
+ *
+ *   wall clock chain (ticks every 100ms, also when machine stops)
+ *
+ *   +-----+   +------+   +--------+   +--------+   +---------+
+ *   |days_|<--|hours_|<--|minutes_|<--|seconds_|<--|sec_10th_|
+ *   +-----+   +--:---+   +---:----+   +--------+   +---------+
+ *                :           : on overflow
+ *                :           v
+ *                :     +-------------+  samples  +---------------+
+ *                :     | RateTracker |---------->| operation     |
+ *                :     | (per minute)|           | hours meter   |
+ *                :     +-------------+           | (ticks only   |
+ *                +---->| RateTracker |---------->|  while the    |
+ *                      | (per hour)  |           |  machine runs)|
+ *                      +-------------+           +---------------+
+ *
+ * Per tick nothing is added beyond the (empty) observer check of
+ * a stage that did NOT overflow; the tracker's results are held
+ * in atomics so other threads can read them without locking.
+*/
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class BasicCounter {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() { ++value_; }
+    void reset() { value_ = 0;}
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public BasicCounter {
+public:
+    LimitCounter() =default;
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr();
+    void attach(std::function<void()> observer) {
+        observers_.push_back(std::move(observer));
+    }
+private:
+    virtual void overflowed() { /*empty*/ }
+    std::vector<std::function<void()>> observers_;
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    BasicCounter::incr();
+    if (get_value() == limit_) {
+        reset();
+        overflowed();              // carry first, so observers see
+        for (auto& observer : observers_)  // a consistent chain
+            observer();
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(std::function<void()> next)
+        : next_{next}
+    {}
+private:
+    void overflowed() override;
+    std::function<void()> next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    if (next_) next_();
+}
+
+// Closes a window whenever `on_window_end` is called (eg. from a
+// stage overflow), taking the difference of `source()` to its
+// value at the end of the prior window as the window's count.
+class RateTracker {
+public:
+    RateTracker(std::function<unsigned long long()> source, double alpha)
+        : source_{std::move(source)}, alpha_{alpha}
+        , last_total_{source_()}
+    {}
+    void on_window_end();
+    // lock-free reads, each value individually consistent
+    unsigned long long get_last_count() const { return last_count_.load(); }
+    double get_ewma() const { return ewma_.load(); }
+    unsigned long long get_windows() const { return windows_.load(); }
+private:
+    static_assert(std::atomic<double>::is_always_lock_free);
+    std::function<unsigned long long()> const source_;
+    double const alpha_;
+    unsigned long long last_total_;
+    std::atomic<unsigned long long> last_count_{0};
+    std::atomic<double> ewma_{0.0};
+    std::atomic<unsigned long long> windows_{0};
+};
+
+void RateTracker::on_window_end() {
+    auto const total = source_();
+    auto const count = total - last_total_;
+    last_total_ = total;
+    auto const windows = windows_.load(std::memory_order_relaxed);
+    auto const ewma = ewma_.load(std::memory_order_relaxed);
+    ewma_.store(windows == 0 ? double(count)
+                             : ewma + alpha_ * (double(count) - ewma),
+                std::memory_order_relaxed);
+    last_count_.store(count, std::memory_order_relaxed);
+    windows_.store(windows + 1, std::memory_order_release);
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+    unsigned long long get_ticks() const;
+    // attach observers to minute, hour or day boundaries
+    void on_minute(std::function<void()> f) { seconds_.attach(std::move(f)); }
+    void on_hour(std::function<void()> f) { minutes_.attach(std::move(f)); }
+    void on_day(std::function<void()> f) { hours_.attach(std::move(f)); }
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{[this]{ days_.incr(); }}
+    , minutes_{[this]{ hours_.incr(); }}
+    , seconds_{[this]{ minutes_.incr(); }}
+    , sec_10th_{[this]{ seconds_.incr(); }}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+unsigned long long OperationHoursMeter::get_ticks() const {
+    return (((days_.get_value() * 24ull + hours_.get_value()) * 60
+             + minutes_.get_value()) * 60 + seconds_.get_value()) * 10
+           + sec_10th_.get_value();
+}
+
+#include <iostream>
+#include <random>
+
+void test_utilisation() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    OperationHoursMeter wall_clock{};   // ticked always
+    OperationHoursMeter operation{};    // ticked while running
+    unsigned long long parts = 0;       // some other event count
+    RateTracker util_per_minute{[&]{ return operation.get_ticks(); }, 0.2};
+    RateTracker util_per_hour{[&]{ return operation.get_ticks(); }, 0.5};
+    RateTracker parts_per_minute{[&]{ return parts; }, 0.2};
+    wall_clock.on_minute([&]{ util_per_minute.on_window_end(); });
+    wall_clock.on_minute([&]{ parts_per_minute.on_window_end(); });
+    wall_clock.on_hour([&]{ util_per_hour.on_window_end(); });
+
+    std::mt19937 rng{17};
+    double const duty[] = {0.9, 0.5, 0.1, 0.75};   // per hour
+    for (double d : duty) {
+        std::bernoulli_distribution running{d};
+        std::bernoulli_distribution part_done{0.01};
+        for (int t = 0; t < 60*60*10; ++t) {
+            wall_clock.incr();
+            if (running(rng)) {
+                operation.incr();
+                parts += part_done(rng);
+            }
+        }
+        std::cout << std::fixed << std::setprecision(1)
+                  << wall_clock.to_string() << " operating "
+                  << operation.to_string() << ", last hour "
+                  << 100.0 * util_per_hour.get_last_count() / (60*60*10)
+                  << "% (ewma " << 100.0 * util_per_hour.get_ewma() / (60*60*10)
+                  << "%), last minute "
+                  << 100.0 * util_per_minute.get_last_count() / (60*10)
+                  << "% (ewma "
+                  << 100.0 * util_per_minute.get_ewma() / (60*10)
+                  << "%), parts/min " << parts_per_minute.get_last_count()
+                  << " (ewma " << parts_per_minute.get_ewma() << ")"
+                  << std::endl;
+    }
+    std::cout << util_per_minute.get_windows() << " minute windows, "
+              << util_per_hour.get_windows() << " hour windows" << std::endl;
+}
+
+#include <chrono>
+
+void benchmark_overhead(unsigned long long n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    OperationHoursMeter plain{};
+    OperationHoursMeter tracked{};
+    RateTracker per_minute{[&]{ return tracked.get_ticks(); }, 0.1};
+    RateTracker per_hour{[&]{ return tracked.get_ticks(); }, 0.1};
+    tracked.on_minute([&]{ per_minute.on_window_end(); });
+    tracked.on_hour([&]{ per_hour.on_window_end(); });
+    auto const t0 = clock::now();
+    for (auto i = 0ull; i < n; ++i) plain.incr();
+    auto const t1 = clock::now();
+    for (auto i = 0ull; i < n; ++i) tracked.incr();
+    auto const t2 = clock::now();
+    auto ns = [n](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    std::cout << std::setprecision(2) << "per tick: "
+              << ns(t1 - t0) << "ns plain, " << ns(t2 - t1)
+              << "ns with two trackers (" << per_minute.get_windows()
+              << " minute windows)" << std::endl;
+}
+
+int main() {
+    test_utilisation();
+    benchmark_overhead(100'000'000);
+}
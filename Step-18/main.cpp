@@ -0,0 +1,545 @@
+/*
+ * ===============================================================
+ * Per Meter History with Delta Compressed Snapshots
+ * ===============================================================
+ * Using the observers of Step-17 a `SnapshotHistory` captures the
+ * (timestamp, tick total) of a meter each time a chosen stage
+ * overflows, eg. every hour of operation. The snapshots are kept
+ * in fixed size blocks taken from a `HistoryPool` shared by all
+ * meters, linked from the oldest to the newest block of a meter.
+ * A block goes back to the pool once ALL its snapshots are older
+ * than `keep` (eg. a week), so a meter holds just as many blocks
+ * as its history of that time span needs. A block is 32 bytes,
+ * enough for a week of a meter that runs all the time:
+ *
+ *    oldest_                                  newest_
+ *   +---------------+   +---------------+   +---------------+
+ *   | base_time     |   | base_time     |   | base_time     |
+ *   | next ---------+-->| next ---------+-->| next (NONE)   |
+ *   | base_total    |   | base_total    |   | base_total    |
+ *   | used          |   | used          |   | used          |
+ *   | bytes[BYTES]  |   | bytes[BYTES]  |   | bytes[BYTES]  |
+ *   +---------------+   +---------------+   +---------------+
+ *
+ * Within a block each snapshot is stored as the DIFFERENCE to its
+ * predecessor, encoded as variable length integers (7 bits per
+ * byte). As a meter that runs all the time produces the very same
+ * difference again and again, repetitions are stored as a single
+ * run length, so a week of hourly snapshots of such a meter takes
+ * only a few bytes beyond the block's base snapshot:
+ *
+ *   record := 0  zigzag(dt)  dv      (a new difference)
+ *           | (run << 1) | 1         (repeat the last one `run` times)
+*/
+#include <climits>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class BasicCounter {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() { ++value_; }
+    void reset() { value_ = 0;}
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public BasicCounter {
+public:
+    LimitCounter() =default;
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr();
+    void attach(std::function<void()> observer) {
+        observers_.push_back(std::move(observer));
+    }
+private:
+    virtual void overflowed() { /*empty*/ }
+    std::vector<std::function<void()>> observers_;
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    BasicCounter::incr();
+    if (get_value() == limit_) {
+        reset();
+        overflowed();              // carry first, so observers see
+        for (auto& observer : observers_)  // a consistent chain
+            observer();
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(std::function<void()> next)
+        : next_{next}
+    {}
+private:
+    void overflowed() override;
+    std::function<void()> next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    if (next_) next_();
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+
+struct Snapshot {
+    std::int64_t time;          // eg. seconds since the epoch
+    std::uint64_t total;        // tick total of the meter
+};
+
+// Blocks shared by the histories of many meters, which take blocks
+// as they need them and give them back once all the snapshots in a
+// block are older than `keep` (eg. a week) before the newest one.
+// Block times are held as 32 bit seconds since the pool's `epoch`.
+template<std::size_t BYTES = 15>
+class HistoryPool {
+public:
+    static constexpr std::uint32_t NONE = ~std::uint32_t{0};
+    struct Block {
+        std::uint32_t base_time;        // since the epoch
+        std::uint32_t next;             // newer block of the same meter
+        std::uint64_t base_total;
+        std::uint8_t used;              // bytes in use
+        std::uint8_t bytes[BYTES];
+    };
+    static_assert(BYTES < 256, "used is a single byte");
+    HistoryPool(std::int64_t epoch, std::int64_t keep)
+        : epoch_{epoch}, keep_{keep}
+    {}
+    std::int64_t get_epoch() const { return epoch_; }
+    std::int64_t get_keep() const { return keep_; }
+    std::uint32_t acquire();
+    void release(std::uint32_t i) { free_.push_back(i); }
+    Block& operator[](std::uint32_t i) { return blocks_[i]; }
+    Block const& operator[](std::uint32_t i) const { return blocks_[i]; }
+    std::size_t blocks_in_use() const { return blocks_.size() - free_.size(); }
+private:
+    std::int64_t const epoch_;
+    std::int64_t const keep_;
+    std::deque<Block> blocks_{};        // not moved when growing
+    std::vector<std::uint32_t> free_{};
+};
+
+template<std::size_t BYTES>
+std::uint32_t HistoryPool<BYTES>::acquire() {
+    if (!free_.empty()) {
+        auto const i = free_.back();
+        free_.pop_back();
+        return i;
+    }
+    if (blocks_.size() == NONE) throw std::length_error{"history pool full"};
+    blocks_.emplace_back();
+    return std::uint32_t(blocks_.size() - 1);
+}
+
+// The history of a single meter. It does NOT keep a pointer to its
+// pool (which would cost 8 bytes per meter), so the pool is passed
+// to each call and `clear()` must return the blocks to it.
+template<std::size_t BYTES = 15>
+class SnapshotHistory {
+public:
+    using Pool = HistoryPool<BYTES>;
+    SnapshotHistory() =default;
+    SnapshotHistory(SnapshotHistory&& other) noexcept;
+    SnapshotHistory& operator=(SnapshotHistory&&) =delete;
+    void capture(Pool& pool, std::int64_t time, std::uint64_t total);
+    // calls `f(Snapshot)` for all snapshots with from <= time <= to
+    template<typename F>
+    void for_each_in(Pool const& pool, std::int64_t from, std::int64_t to,
+                     F f) const;
+    std::size_t size(Pool const& pool) const;
+    std::size_t payload_bytes(Pool const& pool) const;
+    void clear(Pool& pool);
+private:
+    using Block = typename Pool::Block;
+    static constexpr std::size_t MAX_PAIR = 1 + 5 + 5;
+    static constexpr std::size_t MAX_RUN = 3;
+    static_assert(BYTES >= MAX_PAIR + MAX_RUN, "block too small");
+    static void put_varint(Block& b, std::uint64_t v);
+    void flush_run(Pool& pool);
+    void open_block(Pool& pool, std::int64_t time, std::uint64_t total);
+    void drop_expired(Pool& pool, std::int64_t now);
+    template<typename F>
+    static bool decode(Block const& b, std::int64_t epoch,
+                       std::uint32_t pending_run,
+                       std::int64_t from, std::int64_t to, F& f);
+    std::uint32_t oldest_ = Pool::NONE;
+    std::uint32_t newest_ = Pool::NONE;
+    // state of the encoder, relative to the base of the newest block
+    std::uint32_t last_time_ = 0;
+    std::uint32_t last_total_ = 0;
+    std::int32_t last_dt_ = 0;
+    std::uint32_t last_dv_ = 0;
+    std::uint16_t run_ = 0;             // repetitions not yet stored
+};
+
+template<std::size_t BYTES>
+SnapshotHistory<BYTES>::SnapshotHistory(SnapshotHistory&& other) noexcept
+    : oldest_{other.oldest_}, newest_{other.newest_}
+    , last_time_{other.last_time_}, last_total_{other.last_total_}
+    , last_dt_{other.last_dt_}, last_dv_{other.last_dv_}, run_{other.run_}
+{
+    other.oldest_ = other.newest_ = Pool::NONE;
+}
+
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::clear(Pool& pool) {
+    for (auto i = oldest_; i != Pool::NONE; ) {
+        auto const next = pool[i].next;
+        pool.release(i);
+        i = next;
+    }
+    oldest_ = newest_ = Pool::NONE;
+    run_ = 0;
+}
+
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::put_varint(Block& b, std::uint64_t v) {
+    while (v >= 0x80) {
+        b.bytes[b.used++] = std::uint8_t(v | 0x80);
+        v >>= 7;
+    }
+    b.bytes[b.used++] = std::uint8_t(v);
+}
+
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::flush_run(Pool& pool) {
+    if (run_ > 0)
+        put_varint(pool[newest_], (std::uint64_t{run_} << 1) | 1);
+    run_ = 0;
+}
+
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::open_block(Pool& pool, std::int64_t time,
+                                        std::uint64_t total) {
+    auto const since = time - pool.get_epoch();
+    if (since < 0 || since > std::int64_t{UINT32_MAX})
+        throw std::out_of_range{"snapshot time outside the pool's epoch"};
+    auto const i = pool.acquire();
+    pool[i] = Block{std::uint32_t(since), Pool::NONE, total, 0, {}};
+    if (newest_ != Pool::NONE) {
+        flush_run(pool);
+        pool[newest_].next = i;
+    }
+    else
+        oldest_ = i;
+    newest_ = i;
+    last_time_ = 0;
+    last_total_ = 0;
+}
+
+// gives back the oldest blocks as long as the NEXT block still
+// starts no later than `now - keep`, ie. the window stays covered
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::drop_expired(Pool& pool, std::int64_t now) {
+    auto const limit = now - pool.get_keep() - pool.get_epoch();
+    while (oldest_ != newest_) {
+        auto const next = pool[oldest_].next;
+        if (std::int64_t{pool[next].base_time} > limit) return;
+        pool.release(oldest_);
+        oldest_ = next;
+    }
+}
+
+template<std::size_t BYTES>
+void SnapshotHistory<BYTES>::capture(Pool& pool, std::int64_t time,
+                                     std::uint64_t total) {
+    if (newest_ == Pool::NONE) {
+        open_block(pool, time, total);
+        return;
+    }
+    drop_expired(pool, time);
+    auto& b = pool[newest_];
+    auto const base_time = pool.get_epoch() + b.base_time;
+    auto const dt = time - (base_time + last_time_);
+    auto const dv = total - (b.base_total + last_total_);
+    // beyond the narrow encoder state: starts over with a new base
+    auto const since = time - base_time;
+    if (since < 0 || since > std::int64_t{UINT32_MAX}
+     || total - b.base_total > UINT32_MAX || dv > UINT32_MAX
+     || dt < INT32_MIN || dt > INT32_MAX) {
+        open_block(pool, time, total);
+        return;
+    }
+    if (b.used > 0 && dt == last_dt_ && dv == last_dv_ && run_ < UINT16_MAX) {
+        ++run_;
+    }
+    // a new difference: needs room for itself and a later run
+    else if (b.used + (run_ > 0 ? MAX_RUN : 0) + MAX_PAIR + MAX_RUN > BYTES) {
+        open_block(pool, time, total);
+        return;
+    }
+    else {
+        flush_run(pool);
+        put_varint(b, 0);
+        put_varint(b, (std::uint64_t(dt) << 1) ^ std::uint64_t(dt >> 63));
+        put_varint(b, dv);
+        last_dt_ = std::int32_t(dt);
+        last_dv_ = std::uint32_t(dv);
+    }
+    last_time_ = std::uint32_t(since);
+    last_total_ = std::uint32_t(total - b.base_total);
+}
+
+template<std::size_t BYTES>
+template<typename F>
+bool SnapshotHistory<BYTES>::decode(Block const& b, std::int64_t epoch,
+        std::uint32_t pending_run,
+        std::int64_t from, std::int64_t to, F& f) {
+    std::size_t pos = 0;
+    auto get_varint = [&b, &pos] {
+        std::uint64_t v = 0;
+        for (unsigned shift = 0; ; shift += 7) {
+            auto const byte = b.bytes[pos++];
+            v |= std::uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+    };
+    Snapshot s{epoch + b.base_time, b.base_total};
+    std::int64_t dt = 0;
+    std::uint64_t dv = 0;
+    // returns false once beyond `to` (no need to look further)
+    auto emit = [&](std::uint64_t times) {
+        for (; times > 0; --times) {
+            s.time += dt;
+            s.total += dv;
+            if (s.time > to) return false;
+            if (s.time >= from) f(s);
+        }
+        return true;
+    };
+    if (s.time > to) return false;
+    if (s.time >= from) f(s);
+    while (pos < b.used) {
+        auto const tag = get_varint();
+        if (tag & 1) {
+            if (!emit(tag >> 1)) return false;
+            continue;
+        }
+        auto const zz = get_varint();
+        dt = std::int64_t(zz >> 1) ^ -std::int64_t(zz & 1);
+        dv = get_varint();
+        if (!emit(1)) return false;
+    }
+    return emit(pending_run);
+}
+
+template<std::size_t BYTES>
+template<typename F>
+void SnapshotHistory<BYTES>::for_each_in(Pool const& pool,
+                                         std::int64_t from, std::int64_t to,
+                                         F f) const {
+    auto const epoch = pool.get_epoch();
+    for (auto i = oldest_; i != Pool::NONE; i = pool[i].next) {
+        auto const next = pool[i].next;
+        // skip blocks that end before `from` (ie. the next one
+        // starts no later than that)
+        if (next != Pool::NONE && epoch + pool[next].base_time <= from)
+            continue;
+        if (!decode(pool[i], epoch, next == Pool::NONE ? run_ : 0,
+                    from, to, f))
+            return;
+    }
+}
+
+template<std::size_t BYTES>
+std::size_t SnapshotHistory<BYTES>::size(Pool const& pool) const {
+    std::size_t n = 0;
+    for_each_in(pool, INT64_MIN, INT64_MAX, [&n](Snapshot const&) { ++n; });
+    return n;
+}
+
+// the base (4 + 8 bytes) and the encoded differences of all blocks
+template<std::size_t BYTES>
+std::size_t SnapshotHistory<BYTES>::payload_bytes(Pool const& pool) const {
+    std::size_t n = 0;
+    for (auto i = oldest_; i != Pool::NONE; i = pool[i].next)
+        n += 12 + pool[i].used;
+    return n;
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+    unsigned long long get_ticks() const;
+    // attach observers to minute, hour or day boundaries
+    void on_minute(std::function<void()> f) { seconds_.attach(std::move(f)); }
+    void on_hour(std::function<void()> f) { minutes_.attach(std::move(f)); }
+    void on_day(std::function<void()> f) { hours_.attach(std::move(f)); }
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{[this]{ days_.incr(); }}
+    , minutes_{[this]{ hours_.incr(); }}
+    , seconds_{[this]{ minutes_.incr(); }}
+    , sec_10th_{[this]{ seconds_.incr(); }}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+unsigned long long OperationHoursMeter::get_ticks() const {
+    return (((days_.get_value() * 24ull + hours_.get_value()) * 60
+             + minutes_.get_value()) * 60 + seconds_.get_value()) * 10
+           + sec_10th_.get_value();
+}
+
+#include <iostream>
+#include <random>
+
+constexpr std::int64_t WEEK = 7*24*60*60;
+
+void test_hourly_history() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    OperationHoursMeter meter{};
+    std::int64_t now = 1'700'000'000;     // wall clock seconds
+    HistoryPool<> pool{now, WEEK};
+    SnapshotHistory<> history{};
+    std::deque<Snapshot> reference{};     // uncompressed, unbounded
+    meter.on_hour([&]{
+        history.capture(pool, now, meter.get_ticks());
+        reference.push_back({now, meter.get_ticks()});
+    });
+    // three weeks: running all the time, then with random stops
+    std::mt19937 rng{34};
+    std::bernoulli_distribution stopped{0.002};
+    for (int tenth = 0; tenth < 3*7*24*60*60*10; ++tenth) {
+        if (tenth % 10 == 0) ++now;
+        if (tenth < 7*24*60*60*10 || !stopped(rng)) meter.incr();
+    }
+    std::vector<Snapshot> all{};
+    history.for_each_in(pool, INT64_MIN, INT64_MAX,
+                        [&all](Snapshot const& s) { all.push_back(s); });
+    // the newest snapshots, at least all those of the last week
+    std::size_t in_week = 0;
+    for (auto const& s : reference) in_week += (s.time >= now - WEEK);
+    bool ok = all.size() >= in_week && all.size() <= reference.size();
+    auto const skip = reference.size() - all.size();
+    for (std::size_t i = 0; ok && i < all.size(); ++i)
+        ok = all[i].time == reference[skip + i].time
+          && all[i].total == reference[skip + i].total;
+    std::cout << meter.to_string() << ", " << reference.size()
+              << " hourly snapshots taken, " << in_week << " of them in the"
+                 " last week, " << all.size() << " (the newest) kept in "
+              << pool.blocks_in_use() << " blocks, " << history.payload_bytes(pool)
+              << " bytes: " << (ok ? "OK" : "MISMATCH") << std::endl;
+    for (auto hours : {12, 7*24}) {
+        std::size_t in_range = 0, expected = 0;
+        history.for_each_in(pool, now - hours*3600, now,
+                            [&](Snapshot const&) { ++in_range; });
+        for (auto const& s : reference) expected += (s.time >= now - hours*3600);
+        std::cout << "range query for the last " << hours << "h: " << in_range
+                  << " snapshots (expected " << expected << "): "
+                  << (in_range == expected ? "OK" : "MISMATCH") << std::endl;
+    }
+    history.clear(pool);
+    std::cout << "cleared: " << history.size(pool) << " snapshots, "
+              << pool.blocks_in_use() << " blocks in use" << std::endl;
+}
+
+void estimate_population(std::size_t meters) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937 rng{1};
+    std::bernoulli_distribution interrupted{0.1};  // meters with stops
+    std::bernoulli_distribution stops{0.05};       // ... in any hour
+    std::uniform_int_distribution<int> lost{1, 35999};
+    using History = SnapshotHistory<>;
+    std::int64_t const start = 1'700'000'000;
+    History::Pool pool{start, WEEK};
+    std::vector<History> histories{};
+    histories.reserve(meters);
+    std::size_t payload = 0, snapshots = 0, taken = 0, failed = 0;
+    std::vector<Snapshot> reference{};
+    for (std::size_t i = 0; i < meters; ++i) {
+        auto& h = histories.emplace_back();
+        bool const flaky = interrupted(rng);
+        std::int64_t now = start;
+        std::uint64_t total = 0;
+        reference.clear();
+        for (int hour = 0; hour < 2*7*24; ++hour) {   // two weeks
+            now += 3600;
+            if (flaky && stops(rng))
+                now += lost(rng) / 10;        // stood still a while
+            total += 36000;
+            h.capture(pool, now, total);
+            reference.push_back({now, total});
+        }
+        // everything of the last week must still be there
+        auto expected = reference.end();
+        while (expected != reference.begin() && (expected-1)->time >= now - WEEK)
+            --expected;
+        std::size_t found = 0;
+        bool same = true;
+        h.for_each_in(pool, now - WEEK, now, [&](Snapshot const& s) {
+            same = same && expected + found != reference.end()
+                        && expected[found].time == s.time
+                        && expected[found].total == s.total;
+            ++found;
+        });
+        auto const in_week = std::size_t(reference.end() - expected);
+        failed += !same || found != in_week;
+        taken += in_week;
+        snapshots += found;
+        payload += h.payload_bytes(pool);
+    }
+    auto const blocks = pool.blocks_in_use();
+    auto const bytes = blocks * sizeof(History::Pool::Block)
+                     + meters * sizeof(History);
+    std::cout << meters << " meters, two weeks of hourly snapshots: "
+              << snapshots << " of " << taken << " snapshots of the last week"
+                 " found, " << failed << " meters with missing snapshots: "
+              << (failed == 0 && snapshots == taken ? "OK" : "FAIL") << '\n'
+              << blocks << " blocks of " << sizeof(History::Pool::Block)
+              << " bytes (" << double(blocks) / meters << " per meter), "
+              << payload << " bytes of payload (" << double(payload) / snapshots
+              << " bytes per snapshot, uncompressed " << sizeof(Snapshot)
+              << "), " << sizeof(History) << " bytes per meter, "
+              << bytes / (1024*1024) << " MB in total" << std::endl;
+}
+
+int main() {
+    test_hourly_history();
+    estimate_population(1'000'000);
+}
@@ -0,0 +1,271 @@
+/*
+ * ===============================================================
+ * A Wide Top Stage with Narrow Lower Stages
+ * ===============================================================
+ * In all prior Steps the top stage (eg. `days_`) has the same
+ * narrow type as all others and silently wraps, or - with the
+ * `FlexCounter<T,N>` of Step-09 - ALL stages would need to be as
+ * wide as the top one. Here the lower stages are single bytes
+ * while the top stage is a class of its own, given as template
+ * argument to the meter:
+ *
+ *   +---------------------------+   +----+ +----+ +----+ +-----+
+ *   | Top days_                 |<--| hh | | mm | | ss | |10th |
+ *   | - TopStage<std::uint32_t> |   +----+ +----+ +----+ +-----+
+ *   | - TopStage<std::uint64_t> |    std::uint8_t each, the same
+ *   | - TopStage<uint128>       |    for all kinds of top stages
+ *   | - SpillStage: 32 bit, the |
+ *   |   rest in a side table    |
+ *   +---------------------------+
+ *
+ * As a tick reaches the top stage only once per day, its type
+ * makes no difference for `incr()`. Bulk `advance(n)` splits `n`
+ * once into days and the rest, and rendering converts the top
+ * stage with 64 bit arithmetic unless it actually needs more.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+using uint128 = unsigned __int128;
+
+template<typename T>
+class TopStage {
+public:
+    void incr() { ++value_; }
+    void add(std::uint64_t n) { value_ += T(n); }   // wraps if T is narrow
+    uint128 get_value() const { return value_; }
+private:
+    T value_{};
+};
+
+// Holds the lower 32 bits inline and only the (rarely needed) rest
+// in a table shared by all instances, keyed by the address of the
+// instance, which therefore must not be copied or moved.
+class SpillStage {
+public:
+    SpillStage() =default;
+    SpillStage(SpillStage const&) =delete;
+    SpillStage& operator=(SpillStage const&) =delete;
+    ~SpillStage() { if (spilled_) side_table_.erase(this); }
+    void incr() { if (++low_ == 0) spill(1); }
+    void add(std::uint64_t n);
+    uint128 get_value() const;
+    static std::size_t side_table_size() { return side_table_.size(); }
+private:
+    void spill(std::uint64_t high);
+    std::uint32_t low_ = 0;
+    bool spilled_ = false;
+    static std::unordered_map<SpillStage const*, std::uint64_t> side_table_;
+};
+
+std::unordered_map<SpillStage const*, std::uint64_t> SpillStage::side_table_{};
+
+void SpillStage::spill(std::uint64_t high) {
+    side_table_[this] += high;
+    spilled_ = true;
+}
+
+void SpillStage::add(std::uint64_t n) {
+    auto const sum = std::uint64_t{low_} + (n & 0xffff'ffff);
+    low_ = std::uint32_t(sum);
+    auto const high = (n >> 32) + (sum >> 32);
+    if (high) spill(high);
+}
+
+uint128 SpillStage::get_value() const {
+    if (!spilled_) return low_;
+    return (uint128{side_table_.at(this)} << 32) | low_;
+}
+
+// writes the decimal digits of `v` to `out` (room for 39 chars)
+// and returns their number; the 128 bit divisions are only needed
+// for values with more than 19 digits
+std::size_t render_decimal(uint128 v, char* out) {
+    constexpr std::uint64_t E19 = 10'000'000'000'000'000'000ull;
+    char digits[40];
+    int n = 0;
+    auto low_part = [&digits, &n](std::uint64_t w, bool pad) {
+        do { digits[n++] = char('0' + w % 10); w /= 10; } while (w);
+        while (pad && n % 19) digits[n++] = '0';
+    };
+    while (v > ~std::uint64_t{0}) {
+        low_part(std::uint64_t(v % E19), true);
+        v /= E19;
+    }
+    low_part(std::uint64_t(v), false);
+    for (int i = 0; i < n; ++i) out[i] = digits[n - 1 - i];
+    return std::size_t(n);
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <string>
+
+template<typename Top>
+class OperationHoursMeter {
+public:
+    static constexpr std::uint64_t TICKS_PER_DAY = 24*60*60*10;
+    static constexpr std::size_t MAX_TEXT = 39 + 11;
+    void incr();
+    void advance(std::uint64_t n);
+    Top const& get_days() const { return days_; }
+    std::size_t render(char* out) const;
+    std::string to_string() const {
+        char buffer[MAX_TEXT];
+        return {buffer, render(buffer)};
+    }
+private:
+    Top days_;
+    std::uint8_t hours_ = 0;
+    std::uint8_t minutes_ = 0;
+    std::uint8_t seconds_ = 0;
+    std::uint8_t sec_10th_ = 0;
+};
+
+template<typename Top>
+void OperationHoursMeter<Top>::incr() {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    days_.incr();
+}
+
+template<typename Top>
+void OperationHoursMeter<Top>::advance(std::uint64_t n) {
+    std::uint32_t const in_day =
+        ((hours_ * 60u + minutes_) * 60 + seconds_) * 10 + sec_10th_;
+    auto const total = in_day + std::uint32_t(n % TICKS_PER_DAY);
+    auto const days = n / TICKS_PER_DAY + total / TICKS_PER_DAY;
+    auto rest = total % TICKS_PER_DAY;
+    sec_10th_ = std::uint8_t(rest % 10);  rest /= 10;
+    seconds_ = std::uint8_t(rest % 60);   rest /= 60;
+    minutes_ = std::uint8_t(rest % 60);   rest /= 60;
+    hours_ = std::uint8_t(rest);
+    if (days) days_.add(days);
+}
+
+template<typename Top>
+std::size_t OperationHoursMeter<Top>::render(char* out) const {
+    char* p = out + render_decimal(days_.get_value(), out);
+    auto two = [&p](unsigned v) {
+        *p++ = char('0' + v / 10);
+        *p++ = char('0' + v % 10);
+    };
+    *p++ = 'd';
+    two(hours_);
+    *p++ = ':';
+    two(minutes_);
+    *p++ = ':';
+    two(seconds_);
+    *p++ = '.';
+    *p++ = char('0' + sec_10th_);
+    return std::size_t(p - out);
+}
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// independent reference: ticks as 128 bit total, rendered the slow
+// way (`std::ostream` has no `operator<<` for 128 bit integers)
+std::string reference_string(uint128 ticks) {
+    constexpr std::uint64_t TPD = 24*60*60*10;
+    auto days = ticks / TPD;
+    auto const rest = unsigned(ticks % TPD);
+    std::string digits{};
+    do { digits.insert(digits.begin(), char('0' + unsigned(days % 10))); }
+    while ((days /= 10) != 0);
+    std::ostringstream os{};
+    os.fill('0');
+    os << digits
+       << 'd'
+       << std::setw(2) << rest / (60*60*10)
+       << ':'
+       << std::setw(2) << rest % (60*60*10) / (60*10)
+       << ':'
+       << std::setw(2) << rest % (60*10) / 10
+       << '.'
+       << std::setw(1) << rest % 10;
+    return os.str();
+}
+
+template<typename Top>
+void test_long_lived(char const* name, unsigned long jumps) {
+    OperationHoursMeter<Top> meter{};
+    uint128 ticks = 0;
+    std::uint64_t step = 0x9e37'79b9'7f4a'7c15;    // ~2^63 ticks
+    for (unsigned long i = 0; i < jumps; ++i) {
+        meter.advance(step);
+        ticks += step;
+        step = step * 6364136223846793005ull + 1442695040888963407ull;
+        for (int k = 0; k < 100; ++k, ++ticks) meter.incr();
+    }
+    auto const actual = meter.to_string();
+    auto const expected = reference_string(ticks);
+    std::cout << std::setw(24) << std::left << name << std::right
+              << std::setw(2) << sizeof(meter) << " bytes: " << actual
+              << (actual == expected ? " OK" : " WRAPPED, expected " + expected)
+              << std::endl;
+}
+
+void test_wide_top_stages() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    // the days need more than 32 bits after the first jump and
+    // more than 64 bits after about 1'700'000 jumps
+    for (unsigned long jumps : {1'000ul, 100'000ul, 3'000'000ul}) {
+        std::cout << jumps << " jumps of up to 2^64 ticks:" << std::endl;
+        test_long_lived<TopStage<std::uint32_t>>("TopStage<uint32_t>", jumps);
+        test_long_lived<TopStage<std::uint64_t>>("TopStage<uint64_t>", jumps);
+        test_long_lived<TopStage<uint128>>("TopStage<uint128>", jumps);
+        test_long_lived<SpillStage>("SpillStage", jumps);
+    }
+    std::cout << "side table entries left: "
+              << SpillStage::side_table_size() << std::endl;
+}
+
+#include <chrono>
+#include <vector>
+
+template<typename Top>
+void benchmark_incr(char const* name, std::size_t meters, unsigned ticks) {
+    using clock = std::chrono::steady_clock;
+    std::vector<OperationHoursMeter<Top>> all(meters);
+    auto const t0 = clock::now();
+    for (unsigned t = 0; t < ticks; ++t)
+        for (auto& m : all) m.incr();
+    auto const t1 = clock::now();
+    std::vector<char> text(OperationHoursMeter<Top>::MAX_TEXT * meters);
+    std::size_t bytes = 0;
+    for (auto& m : all) bytes += m.render(&text[bytes]);
+    auto const t2 = clock::now();
+    auto ns = [](clock::duration d, double n) {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    std::cout << std::setw(24) << std::left << name << std::right
+              << std::fixed << std::setprecision(2)
+              << ns(t1 - t0, double(meters) * ticks) << "ns per incr, "
+              << ns(t2 - t1, double(meters)) << "ns per render ("
+              << all.front().to_string() << ")" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+void benchmark_top_stages(std::size_t meters, unsigned ticks) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    benchmark_incr<TopStage<std::uint32_t>>("TopStage<uint32_t>", meters, ticks);
+    benchmark_incr<TopStage<std::uint64_t>>("TopStage<uint64_t>", meters, ticks);
+    benchmark_incr<TopStage<uint128>>("TopStage<uint128>", meters, ticks);
+    benchmark_incr<SpillStage>("SpillStage", meters, ticks);
+}
+
+int main() {
+    test_wide_top_stages();
+    benchmark_top_stages(10'000, 20'000);
+}
@@ -0,0 +1,297 @@
+/*
+ * ===============================================================
+ * Random Access to the State Space of a Counter Chain
+ * ===============================================================
+ * A chain of `FlexCounter`s (see Step-09) is a mixed radix number:
+ * with the limits 3 (upper) and 7 (lower) it runs through all the
+ * states 0/0, 0/1 ... 0/6, 1/0 ... 2/6 one increment at a time.
+ * Here the state space of such a chain is a RANGE with a random
+ * access iterator, so it can jump to any index and tell the
+ * distance between two states:
+ *
+ *   index:     0     1   ...   6     7   ...  20    21 (end)
+ *            +-----+-----+---+-----+-----+---+-----+
+ *   state:   | 0/0 | 0/1 |...| 0/6 | 1/0 |...| 2/6 |
+ *            +-----+-----+---+-----+-----+---+-----+
+ *   it + n:  state from index by division (mixed radix digits)
+ *   ++it:    like `incr()` of the chain (no division)
+ *
+ * Hence a nested loop over a multi-dimensional grid can be handed
+ * to the parallel algorithms, which split the index range into
+ * partitions and process these on different cores.
+*/
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+// All states of a chain with the given limits, the most significant
+// (upper) stage first, as a range of random access iterators.
+template<typename T, std::size_t N>
+class ChainSpace {
+public:
+    using State = std::array<T, N>;
+    class iterator;
+    explicit ChainSpace(State const& limits);
+    std::ptrdiff_t size() const { return size_; }
+    State const& limits() const { return limits_; }
+    State state_at(std::ptrdiff_t index) const;
+    std::ptrdiff_t index_of(State const& state) const;
+    iterator begin() const { return {this, 0}; }
+    iterator end() const { return {this, size_}; }
+private:
+    State limits_;
+    std::ptrdiff_t size_;
+};
+
+template<typename T, std::size_t N>
+ChainSpace<T, N>::ChainSpace(State const& limits)
+    : limits_{limits}, size_{1}
+{
+    for (auto const limit : limits_) size_ *= std::ptrdiff_t(limit);
+}
+
+template<typename T, std::size_t N>
+auto ChainSpace<T, N>::state_at(std::ptrdiff_t index) const -> State {
+    State result{};
+    for (std::size_t i = N; i-- > 0; ) {
+        result[i] = T(index % std::ptrdiff_t(limits_[i]));
+        index /= std::ptrdiff_t(limits_[i]);
+    }
+    return result;
+}
+
+template<typename T, std::size_t N>
+std::ptrdiff_t ChainSpace<T, N>::index_of(State const& state) const {
+    std::ptrdiff_t index = 0;
+    for (std::size_t i = 0; i < N; ++i)
+        index = index * std::ptrdiff_t(limits_[i]) + std::ptrdiff_t(state[i]);
+    return index;
+}
+
+template<typename T, std::size_t N>
+class ChainSpace<T, N>::iterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = State;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = State;        // by value: NOT a stashing iterator
+    iterator() =default;
+    iterator(ChainSpace const* space, std::ptrdiff_t index)
+        : space_{space}, index_{index}, state_{space->state_at(index)}
+    {}
+    reference operator*() const { return state_; }
+    value_type operator[](difference_type n) const {
+        return space_->state_at(index_ + n);
+    }
+    std::ptrdiff_t index() const { return index_; }
+    iterator& operator++();
+    iterator& operator--();
+    iterator operator++(int) { auto r = *this; ++*this; return r; }
+    iterator operator--(int) { auto r = *this; --*this; return r; }
+    iterator& operator+=(difference_type n) {
+        index_ += n;
+        state_ = space_->state_at(index_);
+        return *this;
+    }
+    iterator& operator-=(difference_type n) { return *this += -n; }
+    friend iterator operator+(iterator it, difference_type n) { return it += n; }
+    friend iterator operator+(difference_type n, iterator it) { return it += n; }
+    friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(iterator const& a, iterator const& b) {
+        return a.index_ - b.index_;
+    }
+    friend bool operator==(iterator const& a, iterator const& b) { return a.index_ == b.index_; }
+    friend bool operator!=(iterator const& a, iterator const& b) { return a.index_ != b.index_; }
+    friend bool operator<(iterator const& a, iterator const& b) { return a.index_ < b.index_; }
+    friend bool operator>(iterator const& a, iterator const& b) { return a.index_ > b.index_; }
+    friend bool operator<=(iterator const& a, iterator const& b) { return a.index_ <= b.index_; }
+    friend bool operator>=(iterator const& a, iterator const& b) { return a.index_ >= b.index_; }
+private:
+    ChainSpace const* space_ = nullptr;
+    std::ptrdiff_t index_ = 0;
+    State state_{};
+};
+
+template<typename T, std::size_t N>
+auto ChainSpace<T, N>::iterator::operator++() -> iterator& {
+    ++index_;
+    for (std::size_t i = N; i-- > 0; ) {      // like the chain's incr()
+        if (++state_[i] < space_->limits_[i]) break;
+        state_[i] = T{};
+    }
+    return *this;
+}
+
+template<typename T, std::size_t N>
+auto ChainSpace<T, N>::iterator::operator--() -> iterator& {
+    --index_;
+    for (std::size_t i = N; i-- > 0; ) {
+        if (state_[i]-- > T{}) break;
+        state_[i] = space_->limits_[i] - 1;
+    }
+    return *this;
+}
+
+// the state space of a chain made from the given FlexCounter types
+template<typename... Stages>
+auto chain_space() {
+    using T = std::common_type_t<typename Stages::value_type...>;
+    return ChainSpace<T, sizeof...(Stages)>{{T(Stages::MAX)...}};
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC uses of these classes
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+void test_counter_chain(int n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    FlexCounter<int, 3> upper{[]{ return true; }};
+    FlexCounter<int, 7> lower{[&upper]{ return upper.incr(); }};
+    auto const space = chain_space<decltype(upper), decltype(lower)>();
+    std::ostringstream by_chain{}, by_range{};
+    for (int i = 0; i < n; ++i) {
+        by_chain << upper.get_value() << '/' << lower.get_value() << ' ';
+        lower.incr();
+    }
+    int i = 0;
+    for (auto it = space.begin(); i < n; ++i, ++it) {
+        if (it == space.end()) it = space.begin();
+        by_range << (*it)[0] << '/' << (*it)[1] << ' ';
+    }
+    std::cout << by_range.str() << '\n'
+              << (by_chain.str() == by_range.str() ? "same" : "DIFFERENT")
+              << " as with the FlexCounter chain" << std::endl;
+}
+
+#include <algorithm>
+#include <random>
+
+void test_random_access() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    ChainSpace<unsigned, 4> const space{{5, 24, 60, 60}};
+    std::mt19937 rng{36};
+    std::uniform_int_distribution<std::ptrdiff_t> index{0, space.size() - 1};
+    unsigned errors = 0;
+    for (int i = 0; i < 100'000; ++i) {
+        auto const a = index(rng), b = index(rng);
+        auto it = space.begin() + a;
+        auto const jt = space.begin() + b;
+        errors += (jt - it != b - a);
+        errors += (space.index_of(*it) != a);
+        errors += (it[b - a] != *jt);
+        auto const before = *it;
+        errors += (*--(++it) != before);
+    }
+    // stepping over the whole space forwards and backwards
+    auto it = space.begin();
+    for (std::ptrdiff_t i = 0; i < space.size(); ++i, ++it)
+        errors += (*it != space.state_at(i));
+    for (std::ptrdiff_t i = space.size(); i-- > 0; )
+        errors += (*--it != space.state_at(i));
+    // (reverse_iterator dereferences a temporary: `*--tmp`)
+    std::reverse_iterator<decltype(it)> rit{space.end()};
+    for (std::ptrdiff_t i = space.size(); i-- > 0; ++rit)
+        errors += (*rit != space.state_at(i));
+    errors += !std::is_sorted(space.begin(), space.end());
+    auto const found = std::lower_bound(space.begin(), space.end(),
+                                        decltype(space)::State{3, 7, 0, 0});
+    std::cout << space.size() << " states, 3/7/00/00 at index "
+              << found.index() << ", " << errors << " errors" << std::endl;
+}
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// some "expensive" function on a parameter grid
+double evaluate(std::array<unsigned, 3> const& p) {
+    double x = 0.0;
+    for (unsigned k = 1; k <= 16; ++k)
+        x += std::sin(p[0] * 0.1 + k) * std::cos(p[1] * 0.01 * k) / (p[2] + k);
+    return x;
+}
+
+template<typename Policy>
+double grid_sum(Policy&& policy, ChainSpace<unsigned, 3> const& space,
+                std::atomic<long>& visited) {
+    return std::transform_reduce(policy, space.begin(), space.end(),
+        0.0, std::plus<>{}, [&visited](auto const& p) {
+            visited.fetch_add(1, std::memory_order_relaxed);
+            return evaluate(p);
+        });
+}
+
+void benchmark_parameter_grid() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    ChainSpace<unsigned, 3> const space{{100, 200, 100}};
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    };
+    std::atomic<long> seq_visited{0}, par_visited{0};
+    auto const t0 = clock::now();
+    auto const seq = grid_sum(std::execution::seq, space, seq_visited);
+    auto const t1 = clock::now();
+    auto const par = grid_sum(std::execution::par, space, par_visited);
+    auto const t2 = clock::now();
+    // every state exactly once, also with std::for_each
+    std::vector<std::atomic<unsigned char>> seen(std::size_t(space.size()));
+    std::for_each(std::execution::par, space.begin(), space.end(),
+        [&seen, &space](auto const& p) { ++seen[space.index_of(p)]; });
+    auto const once = std::all_of(seen.begin(), seen.end(),
+                                  [](auto const& s) { return s == 1; });
+    std::cout << space.size() << " grid points on "
+              << std::thread::hardware_concurrency() << " core(s)\n"
+              << "seq: " << ms(t1 - t0) << "ms (" << seq_visited << " visited)\n"
+              << "par: " << ms(t2 - t1) << "ms (" << par_visited << " visited)\n"
+              << "sums " << (std::abs(seq - par) < 1e-6 * std::abs(seq) ? "agree" : "DIFFER")
+              << ", each point visited " << (once ? "once" : "NOT once")
+              << std::endl;
+}
+
+int main() {
+    test_counter_chain(25);
+    test_random_access();
+    benchmark_parameter_grid();
+}
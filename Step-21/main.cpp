@@ -0,0 +1,234 @@
+/*
+ * ===============================================================
+ * Replaying a Log of Tick Deltas with a Parallel Prefix Scan
+ * ===============================================================
+ * To know the state of a meter after each entry of a log of tick
+ * deltas, so far all deltas had to be fed through `incr()` one
+ * after the other. But the state after entry `i` only depends on
+ * the SUM of all deltas up to `i`, ie. on an (inclusive) prefix
+ * sum, which can be computed by several threads in two passes:
+ *
+ *   deltas    | block 0  | block 1  | block 2  | block 3  |
+ *             +----------+----------+----------+----------+
+ *   pass 1:     sum s0     sum s1     sum s2     sum s3    (parallel)
+ *   serial:     0          s0         s0+s1      s0+s1+s2  (offsets)
+ *   pass 2:     scan each block starting at its offset and (parallel)
+ *               decompose each total into stage values
+ *             +----------+----------+----------+----------+
+ *   days      |          |          |          |          |
+ *   hours     |          |          |          |          |
+ *   minutes   |  one column per stage, one row per entry  |
+ *   seconds   |          |          |          |          |
+ *   tenths    |          |          |          |          |
+ *             +----------+----------+----------+----------+
+ *
+ * Each delta is read twice and each total decomposed once, so the
+ * work is the same as for a serial scan (plus one addition per
+ * block), but spread evenly over all threads.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+struct StateColumns {
+    explicit StateColumns(std::size_t n)
+        : days(n), hours(n), minutes(n), seconds(n), sec_10th(n)
+    {}
+    std::size_t size() const { return days.size(); }
+    std::vector<std::uint32_t> days;
+    std::vector<std::uint8_t> hours;
+    std::vector<std::uint8_t> minutes;
+    std::vector<std::uint8_t> seconds;
+    std::vector<std::uint8_t> sec_10th;
+};
+
+// Row `i` of the result is the state after adding `deltas[0..i]`
+// to `start` (all in ticks of 1/10 second).
+class DeltaReplay {
+public:
+    // 0 threads (eg. an unknown `hardware_concurrency()`) means 1
+    explicit DeltaReplay(unsigned threads) : threads_{threads ? threads : 1} {}
+    unsigned get_threads() const { return threads_; }
+    StateColumns operator()(std::vector<std::uint32_t> const& deltas,
+                            std::uint64_t start = 0) const;
+private:
+    static void decompose(std::uint64_t total, StateColumns& out,
+                          std::size_t i) {
+        auto const in_day = std::uint32_t(total % (24*60*60*10));
+        out.days[i] = std::uint32_t(total / (24*60*60*10));
+        out.hours[i] = std::uint8_t(in_day / (60*60*10));
+        out.minutes[i] = std::uint8_t(in_day / (60*10) % 60);
+        out.seconds[i] = std::uint8_t(in_day / 10 % 60);
+        out.sec_10th[i] = std::uint8_t(in_day % 10);
+    }
+    unsigned const threads_;
+};
+
+StateColumns DeltaReplay::operator()(std::vector<std::uint32_t> const& deltas,
+                                     std::uint64_t start) const {
+    auto const n = deltas.size();
+    StateColumns result{n};
+    auto const blocks = std::size_t{threads_};
+    auto const first = [n, blocks](std::size_t b) { return n * b / blocks; };
+    std::vector<std::uint64_t> offset(blocks + 1);
+    auto parallel = [blocks](auto const& work) {
+        std::vector<std::thread> pool{};
+        for (std::size_t b = 1; b < blocks; ++b)
+            pool.emplace_back(work, b);
+        work(0);                      // the calling thread does block 0
+        for (auto& t : pool) t.join();
+    };
+    parallel([&](std::size_t b) {
+        std::uint64_t sum = 0;
+        for (auto i = first(b); i < first(b + 1); ++i) sum += deltas[i];
+        offset[b + 1] = sum;
+    });
+    offset[0] = start;
+    for (std::size_t b = 0; b < blocks; ++b) offset[b + 1] += offset[b];
+    parallel([&](std::size_t b) {
+        auto total = offset[b];
+        for (auto i = first(b); i < first(b + 1); ++i) {
+            total += deltas[i];
+            decompose(total, result, i);
+        }
+    });
+    return result;
+}
+
+// above: helper classes to replay MANY meter states at once
+// ---------------------------------------------------------------
+// below: a SPECIFIC meter to replay serially for comparison
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    void incr();
+    std::string to_string() const;
+    bool same_as(StateColumns const& c, std::size_t i) const {
+        return days_ == c.days[i] && hours_ == c.hours[i]
+            && minutes_ == c.minutes[i] && seconds_ == c.seconds[i]
+            && sec_10th_ == c.sec_10th[i];
+    }
+    void store(StateColumns& c, std::size_t i) const {
+        c.days[i] = days_;
+        c.hours[i] = std::uint8_t(hours_);
+        c.minutes[i] = std::uint8_t(minutes_);
+        c.seconds[i] = std::uint8_t(seconds_);
+        c.sec_10th[i] = std::uint8_t(sec_10th_);
+    }
+private:
+    std::uint32_t days_ = 0;
+    unsigned hours_ = 0, minutes_ = 0, seconds_ = 0, sec_10th_ = 0;
+};
+
+void OperationHoursMeter::incr() {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    ++days_;
+}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_
+       << 'd'
+       << std::setw(2) << hours_
+       << ':'
+       << std::setw(2) << minutes_
+       << ':'
+       << std::setw(2) << seconds_
+       << '.'
+       << std::setw(1) << sec_10th_;
+    return os.str();
+}
+
+std::string row_to_string(StateColumns const& c, std::size_t i) {
+    std::ostringstream os{};
+    os.fill('0');
+    os << c.days[i]
+       << 'd'
+       << std::setw(2) << unsigned(c.hours[i])
+       << ':'
+       << std::setw(2) << unsigned(c.minutes[i])
+       << ':'
+       << std::setw(2) << unsigned(c.seconds[i])
+       << '.'
+       << std::setw(1) << unsigned(c.sec_10th[i]);
+    return os.str();
+}
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+std::vector<std::uint32_t> make_deltas(std::size_t n) {
+    std::mt19937 rng{37};
+    std::geometric_distribution<std::uint32_t> delta{0.1};   // mean 9
+    std::vector<std::uint32_t> deltas(n);
+    for (auto& d : deltas) d = delta(rng);
+    return deltas;
+}
+
+void test_replay(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    auto const deltas = make_deltas(n);
+    for (unsigned threads : {0u, 1u, 3u, 8u}) {
+        DeltaReplay const replay{threads};
+        auto const columns = replay(deltas);
+        OperationHoursMeter meter{};
+        std::size_t errors = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            for (auto k = deltas[i]; k > 0; --k) meter.incr();
+            errors += !meter.same_as(columns, i);
+        }
+        std::cout << threads << " thread(s) -> " << replay.get_threads()
+                  << " block(s): last state "
+                  << row_to_string(columns, n - 1) << " (serial "
+                  << meter.to_string() << "), " << errors
+                  << " differences" << std::endl;
+    }
+}
+
+void benchmark_replay(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto const deltas = make_deltas(n);
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d).count();
+    };
+    auto const t0 = clock::now();
+    OperationHoursMeter meter{};
+    StateColumns serial{n};
+    for (std::size_t i = 0; i < n; ++i) {
+        for (auto k = deltas[i]; k > 0; --k) meter.incr();
+        meter.store(serial, i);
+    }
+    auto const t1 = clock::now();
+    std::cout << n << " deltas, serial incr(): " << ms(t1 - t0)
+              << "ms (" << row_to_string(serial, n - 1) << ")" << std::endl;
+    auto const hw = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads : {1u, hw, 4 * hw}) {
+        auto const t2 = clock::now();
+        auto const columns = DeltaReplay{threads}(deltas);
+        auto const t3 = clock::now();
+        std::cout << "scan with " << threads << " thread(s): " << ms(t3 - t2)
+                  << "ms (" << row_to_string(columns, n - 1) << ")" << std::endl;
+    }
+    std::cout << "(" << hw << " hardware thread(s))" << std::endl;
+}
+
+int main() {
+    test_replay(1'000'000);
+    benchmark_replay(20'000'000);
+}
@@ -0,0 +1,360 @@
+/*
+ * ===============================================================
+ * Meters in Shared Memory, Ticked and Read by Several Processes
+ * ===============================================================
+ * So far all meters live inside a single process. Here they are
+ * placed in a POSIX shared memory segment which any number of
+ * worker processes map to tick them, while a monitoring process
+ * (eg. this program started as `./a.out read`) renders them:
+ *
+ *   segment: +-----------------------------------------------+
+ *            | Header: magic, capacity, count, mutex         |
+ *            |-----------------------------------------------|
+ *   slot 0   | name "press-1"  | ticks (atomic 64 bit) | ... | 64 bytes
+ *   slot 1   | name "press-2"  | ticks (atomic 64 bit) | ... | each, so
+ *    ...     |                 |                       |     | no false
+ *            +-----------------------------------------------+ sharing
+ *        ^ fetch_add()   ^ fetch_add()       ^ load()
+ *   [worker 1]       [worker 2]        [monitor]
+ *
+ * As in Step-14 each meter stores its tick TOTAL only, from which
+ * all stage values are derived when rendering. So any read is a
+ * single atomic load and can never be torn, no matter how many
+ * processes increment concurrently. (As the processes do not share
+ * addresses, this requires atomics that are lock-free.) Only adding
+ * a meter takes a mutex, which is ROBUST: if a process dies while
+ * holding it, the next one to lock it takes over.
+*/
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <system_error>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct alignas(64) SharedMeter {
+    static constexpr std::size_t MAX_NAME = 47;
+    void incr() { ticks_.fetch_add(1, std::memory_order_relaxed); }
+    void advance(std::uint64_t n) { ticks_.fetch_add(n, std::memory_order_relaxed); }
+    std::uint64_t get_ticks() const { return ticks_.load(std::memory_order_relaxed); }
+    std::string_view get_name() const { return name_; }
+private:
+    friend class SharedSegment;
+    std::atomic<std::uint64_t> ticks_;
+    char name_[MAX_NAME + 1];
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(sizeof(SharedMeter) == 64);
+
+// RAII handle of a mapping of the segment; the meters in the segment
+// outlive it (until `remove`).
+class SharedSegment {
+public:
+    static SharedSegment create(char const* name, std::uint32_t capacity);
+    static SharedSegment open(char const* name);
+    static void remove(char const* name) { ::shm_unlink(name); }
+    SharedSegment(SharedSegment&& other) noexcept;
+    SharedSegment& operator=(SharedSegment&&) =delete;
+    ~SharedSegment();
+    // the meter with this name, added if not yet there (or null if
+    // the segment is full)
+    SharedMeter* find_or_add(std::string_view name);
+    SharedMeter* find(std::string_view name) const;
+    std::uint32_t size() const { return header_->count.load(std::memory_order_acquire); }
+    std::uint32_t capacity() const { return header_->capacity; }
+    SharedMeter const& operator[](std::uint32_t i) const { return slots()[i]; }
+private:
+    struct alignas(64) Header {
+        static constexpr std::uint64_t MAGIC = 0x434f'554e'444f'574e; // COUNDOWN
+        std::uint64_t magic;
+        std::uint32_t capacity;
+        std::atomic<std::uint32_t> count;   // slots in use
+        pthread_mutex_t lock;               // held while adding
+    };
+    static std::size_t bytes_for(std::uint32_t capacity) {
+        return sizeof(Header) + capacity * sizeof(SharedMeter);
+    }
+    SharedSegment(void* base, std::size_t bytes)
+        : header_{static_cast<Header*>(base)}, bytes_{bytes}
+    {}
+    SharedMeter* slots() const {
+        return reinterpret_cast<SharedMeter*>(header_ + 1);
+    }
+    Header* header_;
+    std::size_t bytes_;
+};
+
+namespace {
+    [[noreturn]] void throw_errno(char const* what) {
+        throw std::system_error{errno, std::generic_category(), what};
+    }
+    void* map(int fd, std::size_t bytes) {
+        auto* const base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) throw_errno("mmap");
+        return base;
+    }
+}
+
+SharedSegment SharedSegment::create(char const* name, std::uint32_t capacity) {
+    int const fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) throw_errno(name);
+    auto const bytes = bytes_for(capacity);
+    if (::ftruncate(fd, off_t(bytes)) < 0) {
+        ::close(fd);
+        ::shm_unlink(name);
+        throw_errno("ftruncate");
+    }
+    void* base;
+    try { base = map(fd, bytes); }
+    catch (...) { ::close(fd); ::shm_unlink(name); throw; }
+    ::close(fd);
+    // the new segment is zero filled, ie. all meters at 0 ticks
+    auto* const header = new (base) Header{};
+    header->capacity = capacity;
+    pthread_mutexattr_t attr;
+    ::pthread_mutexattr_init(&attr);
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int const error = ::pthread_mutex_init(&header->lock, &attr);
+    ::pthread_mutexattr_destroy(&attr);
+    if (error != 0) {
+        ::munmap(base, bytes);
+        ::shm_unlink(name);
+        errno = error;
+        throw_errno("pthread_mutex_init");
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = Header::MAGIC;
+    return {base, bytes};
+}
+
+SharedSegment SharedSegment::open(char const* name) {
+    int const fd = ::shm_open(name, O_RDWR, 0);
+    if (fd < 0) throw_errno(name);
+    struct stat st;
+    if (::fstat(fd, &st) < 0) { ::close(fd); throw_errno("fstat"); }
+    auto const bytes = std::size_t(st.st_size);
+    void* base;
+    try { base = map(fd, bytes); }
+    catch (...) { ::close(fd); throw; }
+    ::close(fd);
+    SharedSegment result{base, bytes};
+    if (bytes < sizeof(Header) || result.header_->magic != Header::MAGIC
+     || bytes < bytes_for(result.header_->capacity)) {
+        errno = EINVAL;
+        throw_errno(name);
+    }
+    return result;
+}
+
+SharedSegment::SharedSegment(SharedSegment&& other) noexcept
+    : header_{other.header_}, bytes_{other.bytes_}
+{
+    other.header_ = nullptr;
+}
+
+SharedSegment::~SharedSegment() {
+    if (header_) ::munmap(header_, bytes_);
+}
+
+SharedMeter* SharedSegment::find(std::string_view name) const {
+    auto const n = size();                   // acquire: names complete
+    for (std::uint32_t i = 0; i < n; ++i)
+        if (slots()[i].get_name() == name) return &slots()[i];
+    return nullptr;
+}
+
+SharedMeter* SharedSegment::find_or_add(std::string_view name) {
+    if (auto* const found = find(name)) return found;
+    if (name.size() > SharedMeter::MAX_NAME) return nullptr;
+    int const error = ::pthread_mutex_lock(&header_->lock);
+    if (error == EOWNERDEAD)
+        // the owner died while adding, but only the final store of
+        // `count` publishes a slot, so any partial slot is unused
+        ::pthread_mutex_consistent(&header_->lock);
+    else if (error != 0) {
+        errno = error;
+        throw_errno("pthread_mutex_lock");
+    }
+    auto* result = find(name);               // maybe added meanwhile
+    auto const n = header_->count.load(std::memory_order_relaxed);
+    if (!result && n < header_->capacity) {
+        result = &slots()[n];
+        std::memcpy(result->name_, name.data(), name.size());
+        result->name_[name.size()] = '\0';
+        header_->count.store(n + 1, std::memory_order_release);
+    }
+    ::pthread_mutex_unlock(&header_->lock);
+    return result;
+}
+
+// above: helper classes to SHARE many counters between processes
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of meter built on a shared counter
+
+#include <string>
+
+class OperationHoursMeter {
+public:
+    static constexpr std::size_t MAX_TEXT = 20 + 11;
+    explicit OperationHoursMeter(SharedMeter& shared)
+        : shared_{shared}
+    {}
+    void incr() { shared_.incr(); }
+    void advance(std::uint64_t n) { shared_.advance(n); }
+    std::size_t render(char* out) const { return render(shared_.get_ticks(), out); }
+    std::string to_string() const {
+        char buffer[MAX_TEXT];
+        return {buffer, render(buffer)};
+    }
+    // renders any tick total, eg. read from a segment
+    static std::size_t render(std::uint64_t ticks, char* out);
+private:
+    SharedMeter& shared_;
+};
+
+std::size_t OperationHoursMeter::render(std::uint64_t ticks, char* out) {
+    char digits[20];
+    auto days = ticks / (24*60*60*10);
+    int n = 0;
+    do { digits[n++] = char('0' + days % 10); days /= 10; } while (days);
+    char* p = out;
+    while (n > 0) *p++ = digits[--n];
+    auto const r = unsigned(ticks % (24*60*60*10));
+    auto two = [&p](unsigned v) {
+        *p++ = char('0' + v / 10);
+        *p++ = char('0' + v % 10);
+    };
+    *p++ = 'd';
+    two(r / (60*60*10));
+    *p++ = ':';
+    two(r % (60*60*10) / (60*10));
+    *p++ = ':';
+    two(r % (60*10) / 10);
+    *p++ = '.';
+    *p++ = char('0' + r % 10);
+    return std::size_t(p - out);
+}
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <sys/wait.h>
+
+char const* const SEGMENT = "/coundown-step22";
+
+SharedMeter& find_or_add(SharedSegment& segment, std::string const& name) {
+    if (auto* const meter = segment.find_or_add(name)) return *meter;
+    throw std::runtime_error{"no room for meter " + name};
+}
+
+// a worker process: ticks its own meter and the common one
+void work(unsigned id, unsigned long ticks) {
+    auto segment = SharedSegment::open(SEGMENT);
+    OperationHoursMeter all{find_or_add(segment, "all-presses")};
+    OperationHoursMeter own{find_or_add(segment, "press-" + std::to_string(id))};
+    for (unsigned long t = 0; t < ticks; ++t) {
+        own.incr();
+        all.incr();
+    }
+    own.advance(10 * 60 * 60 * 10);     // plus 10 hours, in bulk
+    all.advance(10 * 60 * 60 * 10);
+}
+
+void run_workers(unsigned workers, unsigned long ticks, std::uint32_t capacity) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    SharedSegment::remove(SEGMENT);      // left over from a crash?
+    auto segment = SharedSegment::create(SEGMENT, capacity);
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<pid_t> children{};
+    for (unsigned id = 1; id <= workers; ++id) {
+        auto const pid = ::fork();
+        if (pid < 0) throw_errno("fork");
+        if (pid == 0) {
+            int status = 0;
+            try { work(id, ticks * id); }
+            catch (std::exception const& ex) {
+                std::cerr << "worker " << id << ": " << ex.what() << std::endl;
+                status = 1;
+            }
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+    // monitor while the workers run: totals must never go back
+    std::uint64_t last = 0, reads = 0, regressions = 0;
+    unsigned running = workers, failed = 0;
+    while (running > 0) {
+        if (auto const* all = segment.find("all-presses")) {
+            auto const now = all->get_ticks();
+            regressions += (now < last);
+            last = now;
+            ++reads;
+        }
+        int status;
+        for (auto& pid : children)
+            if (pid > 0 && ::waitpid(pid, &status, WNOHANG) == pid) {
+                pid = 0;
+                --running;
+                failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+            }
+    }
+    auto const secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << workers << " worker processes, " << failed << " failed, "
+              << secs << "s, " << reads << " reads by the monitor, "
+              << regressions << " regressions" << std::endl;
+    if (failed > 0) return;               // totals incomplete
+    std::uint64_t expected = 0, sum = 0;
+    for (unsigned id = 1; id <= workers; ++id) {
+        expected += ticks * id + 10 * 60 * 60 * 10;
+        sum += segment.find("press-" + std::to_string(id))->get_ticks();
+    }
+    auto const total = segment.find("all-presses")->get_ticks();
+    std::cout << "all-presses: "
+              << OperationHoursMeter{*segment.find("all-presses")}.to_string()
+              << (total == expected && sum == expected ? " OK" : " WRONG")
+              << std::endl;
+}
+
+// the reader tool: renders all meters of the segment
+void read_segment() {
+    auto const segment = SharedSegment::open(SEGMENT);
+    std::cout << SEGMENT << ": " << segment.size() << " of "
+              << segment.capacity() << " meters" << std::endl;
+    char text[OperationHoursMeter::MAX_TEXT];
+    for (std::uint32_t i = 0; i < segment.size(); ++i) {
+        auto const& meter = segment[i];
+        std::cout << "  " << meter.get_name() << ' '
+                  << std::string_view{text,
+                        OperationHoursMeter::render(meter.get_ticks(), text)}
+                  << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string_view const mode = (argc > 1) ? argv[1] : "run";
+    try {
+        if (mode == "read") read_segment();
+        else if (mode == "remove") SharedSegment::remove(SEGMENT);
+        else {
+            run_workers(4, 1000, 3);        // too small: 2 workers fail
+            run_workers(4, 5'000'000, 16);
+        }
+    }
+    catch (std::exception const& ex) {
+        std::cerr << argv[0] << ": " << ex.what() << std::endl;
+        return 1;
+    }
+}
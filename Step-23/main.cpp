@@ -0,0 +1,340 @@
+/*
+ * ===============================================================
+ * Meter Layouts from Format Strings Parsed at Compile Time
+ * ===============================================================
+ * All prior Steps hard-code the layout `NdHH:MM:SS.t` in their
+ * `to_string()`. Here the layout is given as a format string with
+ * fields in braces, which is a TEMPLATE ARGUMENT. So it is parsed
+ * (and checked) by the compiler, which then generates a writer for
+ * exactly this layout - at run time nothing is parsed any more:
+ *
+ *   MeterFormat<"{D}d{hh}:{mm}:{ss}.{t}">::render(ticks, out)
+ *                 |  |  |   |
+ *                 |  |  |   +-- each field becomes a step of the
+ *                 |  |  +------ writer, each literal a fixed size
+ *                 |  +--------- copy, eg.:
+ *                 +------------   digits(days); 'd'; two(hh); ':'
+ *
+ *   {D} {H} {M} {S}   total days, hours, minutes, seconds
+ *   {h} {m} {s}       hours of day, minutes of hour ... (no padding)
+ *   {hh} {mm} {ss}    the same, with two digits
+ *   {t}               tenths of a second
+ *   {{ and }}         literal braces
+ *
+ * An unknown field or an unbalanced brace is a compile time error.
+*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+template<std::size_t N>
+struct FixedString {
+    constexpr FixedString(char const (&s)[N]) {
+        for (std::size_t i = 0; i < N; ++i) text[i] = s[i];
+    }
+    constexpr std::string_view view() const { return {text, N - 1}; }
+    char text[N]{};
+};
+
+enum class Field : std::uint8_t {
+    Literal,
+    Days, TotalHours, TotalMinutes, TotalSeconds,
+    Hours, Minutes, Seconds,
+    Hours2, Minutes2, Seconds2,
+    Tenths,
+};
+
+struct Piece {
+    Field field;
+    std::size_t begin = 0;     // of a literal, in the unescaped text
+    std::size_t length = 0;
+};
+
+template<std::size_t N>
+struct ParsedFormat {
+    std::array<Piece, N> pieces{};
+    std::size_t count = 0;
+    std::array<char, N> literals{};     // unescaped literal text
+};
+
+constexpr Field field_named(std::string_view name) {
+    constexpr std::pair<std::string_view, Field> names[] = {
+        {"D", Field::Days}, {"H", Field::TotalHours},
+        {"M", Field::TotalMinutes}, {"S", Field::TotalSeconds},
+        {"h", Field::Hours}, {"m", Field::Minutes}, {"s", Field::Seconds},
+        {"hh", Field::Hours2}, {"mm", Field::Minutes2},
+        {"ss", Field::Seconds2}, {"t", Field::Tenths},
+    };
+    for (auto const& [n, f] : names)
+        if (n == name) return f;
+    throw "unknown field in meter format";
+}
+
+// throws (ie. does not compile when used in a constant expression)
+// if `format` is not valid
+template<std::size_t N>
+constexpr ParsedFormat<N> parse_format(std::string_view format) {
+    ParsedFormat<N> result{};
+    std::size_t literal_end = 0;
+    auto add_literal_char = [&](char c) {
+        auto const count = result.count;
+        if (count == 0 || result.pieces[count - 1].field != Field::Literal)
+            result.pieces[result.count++] = {Field::Literal, literal_end, 0};
+        result.literals[literal_end++] = c;
+        ++result.pieces[result.count - 1].length;
+    };
+    for (std::size_t i = 0; i < format.size(); ++i) {
+        auto const c = format[i];
+        if (c == '}') {
+            if (i + 1 < format.size() && format[i + 1] == '}') {
+                add_literal_char('}');
+                ++i;
+                continue;
+            }
+            throw "unbalanced '}' in meter format";
+        }
+        if (c != '{') {
+            add_literal_char(c);
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '{') {
+            add_literal_char('{');
+            ++i;
+            continue;
+        }
+        auto const close = format.find('}', i);
+        if (close == std::string_view::npos)
+            throw "unbalanced '{' in meter format";
+        result.pieces[result.count++] =
+            {field_named(format.substr(i + 1, close - i - 1))};
+        i = close;
+    }
+    return result;
+}
+
+constexpr std::size_t max_width(Piece const& p) {
+    switch (p.field) {
+    case Field::Literal: return p.length;
+    case Field::Hours2: case Field::Minutes2: case Field::Seconds2: return 2;
+    case Field::Hours: case Field::Minutes: case Field::Seconds: return 2;
+    case Field::Tenths: return 1;
+    default: return 20;                 // any std::uint64_t
+    }
+}
+
+namespace detail {
+    inline char* digits(std::uint64_t v, char* p) {
+        char buffer[20];
+        int n = 0;
+        do { buffer[n++] = char('0' + v % 10); v /= 10; } while (v);
+        while (n > 0) *p++ = buffer[--n];
+        return p;
+    }
+    inline char* two(unsigned v, char* p) {
+        p[0] = char('0' + v / 10);
+        p[1] = char('0' + v % 10);
+        return p + 2;
+    }
+    inline char* upto_two(unsigned v, char* p) {
+        return (v < 10) ? (*p = char('0' + v), p + 1) : two(v, p);
+    }
+}
+
+template<FixedString Format>
+class MeterFormat {
+    static constexpr auto N = Format.view().size() + 1;
+    static constexpr auto parsed = parse_format<N>(Format.view());
+    template<std::size_t I>
+    static char* step(std::uint64_t ticks, char* p) {
+        constexpr auto piece = parsed.pieces[I];
+        constexpr std::uint32_t TPD = 24*60*60*10;
+        if constexpr (piece.field == Field::Literal) {
+            std::memcpy(p, &parsed.literals[piece.begin], piece.length);
+            return p + piece.length;
+        }
+        else if constexpr (piece.field == Field::Days) return detail::digits(ticks / TPD, p);
+        else if constexpr (piece.field == Field::TotalHours) return detail::digits(ticks / (60*60*10), p);
+        else if constexpr (piece.field == Field::TotalMinutes) return detail::digits(ticks / (60*10), p);
+        else if constexpr (piece.field == Field::TotalSeconds) return detail::digits(ticks / 10, p);
+        else if constexpr (piece.field == Field::Hours) return detail::upto_two(unsigned(ticks % TPD / (60*60*10)), p);
+        else if constexpr (piece.field == Field::Minutes) return detail::upto_two(unsigned(ticks % (60*60*10) / (60*10)), p);
+        else if constexpr (piece.field == Field::Seconds) return detail::upto_two(unsigned(ticks % (60*10) / 10), p);
+        else if constexpr (piece.field == Field::Hours2) return detail::two(unsigned(ticks % TPD / (60*60*10)), p);
+        else if constexpr (piece.field == Field::Minutes2) return detail::two(unsigned(ticks % (60*60*10) / (60*10)), p);
+        else if constexpr (piece.field == Field::Seconds2) return detail::two(unsigned(ticks % (60*10) / 10), p);
+        else return *p = char('0' + ticks % 10), p + 1;
+    }
+    template<std::size_t... Is>
+    static char* steps(std::uint64_t ticks, char* p, std::index_sequence<Is...>) {
+        ((p = step<Is>(ticks, p)), ...);
+        return p;
+    }
+public:
+    static constexpr std::size_t MAX_TEXT = [] {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < parsed.count; ++i)
+            n += max_width(parsed.pieces[i]);
+        return n;
+    }();
+    // writes at most MAX_TEXT chars to `out`, returns their number
+    static std::size_t render(std::uint64_t ticks, char* out) {
+        return std::size_t(steps(ticks, out,
+                           std::make_index_sequence<parsed.count>{}) - out);
+    }
+};
+
+// above: helper classes to RENDER counters in many different ways
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of meter using them
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+class OperationHoursMeter {
+public:
+    OperationHoursMeter() =default;
+    explicit OperationHoursMeter(unsigned long long value)
+        : value_{value}
+    {}
+    void incr() { ++value_; }
+    unsigned long long get_ticks() const { return value_; }
+    std::string to_string() const;
+    template<FixedString Format = "{D}d{hh}:{mm}:{ss}.{t}">
+    std::size_t render(char* out) const {
+        return MeterFormat<Format>::render(value_, out);
+    }
+    template<FixedString Format = "{D}d{hh}:{mm}:{ss}.{t}">
+    std::string format() const {
+        char buffer[MeterFormat<Format>::MAX_TEXT];
+        return {buffer, render<Format>(buffer)};
+    }
+private:
+    unsigned long long value_{};
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << value_ / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value_ % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value_ % 10);
+    return os.str();
+}
+
+// the generic path: the same format language, parsed for EACH call
+std::string format_at_runtime(std::string_view format, unsigned long long ticks) {
+    std::string result{};
+    for (std::size_t i = 0; i < format.size(); ++i) {
+        if ((format[i] == '{' || format[i] == '}')
+         && i + 1 < format.size() && format[i + 1] == format[i]) {
+            result += format[i++];
+            continue;
+        }
+        if (format[i] != '{') {
+            result += format[i];
+            continue;
+        }
+        auto const close = format.find('}', i);
+        auto const name = format.substr(i + 1, close - i - 1);
+        i = close;
+        std::ostringstream os{};
+        os.fill('0');
+        if (name == "D") os << ticks / (24*60*60*10);
+        else if (name == "H") os << ticks / (60*60*10);
+        else if (name == "M") os << ticks / (60*10);
+        else if (name == "S") os << ticks / 10;
+        else if (name == "h") os << ticks % (24*60*60*10) / (60*60*10);
+        else if (name == "m") os << ticks % (60*60*10) / (60*10);
+        else if (name == "s") os << ticks % (60*10) / 10;
+        else if (name == "hh") os << std::setw(2) << ticks % (24*60*60*10) / (60*60*10);
+        else if (name == "mm") os << std::setw(2) << ticks % (60*60*10) / (60*10);
+        else if (name == "ss") os << std::setw(2) << ticks % (60*10) / 10;
+        else if (name == "t") os << ticks % 10;
+        result += os.str();
+    }
+    return result;
+}
+
+// MeterFormat<"{hh}:{mn}"> or MeterFormat<"{hh"> do NOT compile
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define LAYOUTS(X) \
+    X("{D}d{hh}:{mm}:{ss}.{t}") \
+    X("{hh}:{mm}:{ss}") \
+    X("{H}h") \
+    X("P{D}DT{h}H{m}M{s}.{t}S") \
+    X("{{{S}.{t}s}}")
+
+void test_layouts() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::mt19937_64 rng{39};
+    std::vector<OperationHoursMeter> meters{OperationHoursMeter{0},
+                                            OperationHoursMeter{~0ull}};
+    for (int i = 0; i < 100'000; ++i)
+        meters.emplace_back(rng() >> (rng() % 64));
+    OperationHoursMeter const sample{3*24*60*60*10 + 4*60*60*10 + 5*60*10 + 6*10 + 7};
+    unsigned errors = 0;
+    for (auto const& m : meters)
+        errors += (m.format() != m.to_string());
+#define CHECK(F) \
+    for (auto const& m : meters) \
+        errors += (m.format<F>() != format_at_runtime(F, m.get_ticks())); \
+    std::cout << std::setw(24) << std::left << F << std::right \
+              << " max. " << std::setw(2) << MeterFormat<F>::MAX_TEXT \
+              << " chars: " << sample.format<F>() << std::endl;
+    LAYOUTS(CHECK)
+#undef CHECK
+    std::cout << errors << " differences to the generic path" << std::endl;
+}
+
+void benchmark_layouts(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    std::mt19937_64 rng{1};
+    std::vector<OperationHoursMeter> meters{};
+    for (std::size_t i = 0; i < n; ++i)
+        meters.emplace_back(rng() % (24*60*60*10ull * 100'000));
+    std::vector<char> out(n * 64);
+    auto ns = [n](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    std::cout << std::fixed << std::setprecision(1);
+#define BENCH(F) { \
+        auto const t0 = clock::now(); \
+        std::size_t bytes = 0; \
+        for (auto const& m : meters) bytes += m.render<F>(&out[bytes]); \
+        auto const t1 = clock::now(); \
+        for (auto const& m : meters) bytes -= format_at_runtime(F, m.get_ticks()).size(); \
+        auto const t2 = clock::now(); \
+        std::cout << std::setw(24) << std::left << F << std::right \
+                  << std::setw(6) << ns(t1 - t0) << "ns compiled, " \
+                  << std::setw(6) << ns(t2 - t1) << "ns generic" \
+                  << (bytes ? " LENGTHS DIFFER" : "") << std::endl; \
+    }
+    LAYOUTS(BENCH)
+#undef BENCH
+    auto const t0 = clock::now();
+    std::size_t bytes = 0;
+    for (auto const& m : meters) bytes += m.to_string().size();
+    std::cout << "to_string() with iostream: " << ns(clock::now() - t0)
+              << "ns (" << bytes << " bytes)" << std::endl;
+}
+
+int main() {
+    test_layouts();
+    benchmark_layouts(200'000);
+}
@@ -0,0 +1,231 @@
+/*
+ * ===============================================================
+ * A Lazy Meter Derived from a Clock
+ * ===============================================================
+ * The `OperationHoursMeter` of Step-00 must be ticked every 100ms,
+ * ie. 600 times a minute, even if it is read only once a minute.
+ * Here no ticking takes place at all: a meter for operation time
+ * only stores when the current period of operation started and
+ * the operation time accumulated in all prior periods. The stage
+ * values are derived from the clock when (and only when) read:
+ *
+ *          running         paused          running
+ *   -----|=================|...............|==========|--> clock
+ *        start_            pause()         resume()   now
+ *                          accumulated_ += now-start_ start_ = now
+ *
+ *   ticks = (accumulated_ + (running_ ? now - start_ : 0)) / 100ms
+ *
+ * The accessors and `to_string()` derive all stages from a SINGLE
+ * reading of the clock, so they are always consistent with each
+ * other. To read many meters at the same point in time the clock
+ * can also be read once and handed over.
+*/
+#include <chrono>
+#include <cstdint>
+#include <ratio>
+#include <string>
+
+template<typename Clock = std::chrono::steady_clock>
+class LazyOperationHoursMeter {
+public:
+    using clock = Clock;
+    using time_point = typename Clock::time_point;
+    using ticks = std::chrono::duration<std::uint64_t, std::deci>;
+    // starts running (or paused) at the time given
+    explicit LazyOperationHoursMeter(bool running = true,
+                                     time_point now = Clock::now())
+        : start_{now}, running_{running}
+    {}
+    void pause(time_point now = Clock::now());
+    void resume(time_point now = Clock::now());
+    bool is_running() const { return running_; }
+    // bumps by 100ms like `incr()` of the eager meters (eg. to add
+    // operation time that was not measured)
+    void incr() { accumulated_ += ticks{1}; }
+    std::uint64_t get_ticks(time_point now = Clock::now()) const;
+    std::string to_string(time_point now = Clock::now()) const;
+private:
+    // time since `start_`, none if `now` is before it (eg. when the
+    // meter was created with a time that was still to come)
+    typename Clock::duration elapsed(time_point now) const {
+        return (now > start_) ? now - start_ : typename Clock::duration{};
+    }
+    time_point start_;                        // of the current period
+    typename Clock::duration accumulated_{};  // of all prior periods
+    bool running_;
+};
+
+template<typename Clock>
+void LazyOperationHoursMeter<Clock>::pause(time_point now) {
+    if (!running_) return;
+    accumulated_ += elapsed(now);
+    running_ = false;
+}
+
+template<typename Clock>
+void LazyOperationHoursMeter<Clock>::resume(time_point now) {
+    if (running_) return;
+    start_ = now;
+    running_ = true;
+}
+
+template<typename Clock>
+std::uint64_t LazyOperationHoursMeter<Clock>::get_ticks(time_point now) const {
+    auto const total = running_ ? accumulated_ + elapsed(now) : accumulated_;
+    return std::chrono::floor<ticks>(total).count();
+}
+
+// above: helper class to DERIVE a counter from a clock
+// ---------------------------------------------------------------
+// below: rendering it like the SPECIFIC counters of prior Steps
+
+#include <iomanip>
+#include <sstream>
+
+template<typename Clock>
+std::string LazyOperationHoursMeter<Clock>::to_string(time_point now) const {
+    auto const value = get_ticks(now);
+    std::ostringstream os{};
+    os.fill('0');
+    os << value / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value % 10);
+    return os.str();
+}
+
+class OperationHoursMeter {                   // as in Step-00
+public:
+    OperationHoursMeter() =default;
+    std::string to_string() const;
+    void incr() { ++value_; }
+private:
+    unsigned long long value_{};
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << value_ / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value_ % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value_ % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value_ % 10);
+    return os.str();
+}
+
+// a clock that only moves when told so (for repeatable tests)
+struct ManualClock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+    static constexpr bool is_steady = true;
+    static time_point now() { return now_; }
+    static void advance(duration d) { now_ += d; }
+    inline static time_point now_{};
+};
+
+#include <iostream>
+#include <random>
+#include <thread>
+
+void test_against_eager(unsigned long long ms) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    LazyOperationHoursMeter<ManualClock> lazy{};
+    OperationHoursMeter eager{};
+    std::mt19937 rng{40};
+    std::uniform_int_distribution<int> period{1, 3*60*60*10};  // x 100ms
+    bool running = true;
+    unsigned errors = 0, checks = 0;
+    for (unsigned long long done = 0; done < ms; ) {
+        auto const n = period(rng);
+        for (int i = 0; i < n; ++i) {
+            ManualClock::advance(std::chrono::milliseconds{100});
+            if (running) eager.incr();
+            if (i % 997 == 0) {
+                errors += (lazy.to_string() != eager.to_string());
+                ++checks;
+            }
+        }
+        done += n * 100ull;
+        if (running) lazy.pause(); else lazy.resume();
+        running = !running;
+    }
+    std::cout << lazy.to_string() << " (eager " << eager.to_string()
+              << "), " << errors << " differences in " << checks
+              << " checks" << std::endl;
+}
+
+void test_steady_clock() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using namespace std::chrono_literals;
+    LazyOperationHoursMeter<> meter{};
+    std::this_thread::sleep_for(250ms);
+    meter.pause();
+    std::cout << "after 250ms running: " << meter.to_string() << std::endl;
+    std::this_thread::sleep_for(200ms);
+    std::cout << "after 200ms paused:  " << meter.to_string() << std::endl;
+    meter.resume();
+    std::this_thread::sleep_for(150ms);
+    std::cout << "after 150ms running: " << meter.to_string() << std::endl;
+    // started at a time still to come: no operation time before it
+    auto const later = std::chrono::steady_clock::now() + 1h;
+    LazyOperationHoursMeter<> future{true, later};
+    std::cout << "started 1h ahead: " << future.to_string() << " now, "
+              << future.to_string(later + 1h) << " 1h after its start";
+    future.pause();
+    std::cout << ", paused before its start: " << future.to_string()
+              << std::endl;
+}
+
+#include <vector>
+
+// the cost of one minute of operation for many meters: the eager
+// ones need 600 ticks each, the lazy ones nothing until read
+void benchmark_minute(std::size_t meters) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::vector<OperationHoursMeter> eager(meters);
+    // the lazy meters started a minute ago, read exactly a minute
+    // after their start with the single clock reading
+    auto const begin = clock::now() - std::chrono::minutes{1};
+    std::vector<LazyOperationHoursMeter<>> lazy(meters,
+        LazyOperationHoursMeter<>{true, begin});
+    auto const t0 = clock::now();
+    for (int tick = 0; tick < 60*10; ++tick)
+        for (auto& m : eager) m.incr();
+    auto const t1 = clock::now();
+    std::uint64_t sum = 0;
+    for (auto const& m : lazy) sum += m.get_ticks();
+    auto const t2 = clock::now();
+    auto const now = begin + std::chrono::minutes{1};   // one reading
+    for (auto const& m : lazy) sum += m.get_ticks(now);
+    auto const t3 = clock::now();
+    std::cout << meters << " meters, one minute:\n  eager: "
+              << ms(t1 - t0) << "ms for " << 600 * meters << " ticks\n"
+              << "  lazy:  " << ms(t2 - t1) << "ms to read all, "
+              << ms(t3 - t2) << "ms with a single clock reading\n"
+              << "(eager " << eager.front().to_string() << ", lazy "
+              << lazy.front().to_string(now) << ", " << sum
+              << " ticks read)" << std::endl;
+}
+
+int main() {
+    test_against_eager(30ull*24*60*60*1000);
+    test_steady_clock();
+    benchmark_minute(1'000'000);
+}
@@ -0,0 +1,264 @@
+/*
+ * ===============================================================
+ * Relocatable Chains with Positional Links
+ * ===============================================================
+ * The chains of all prior Steps link their stages with POINTERS,
+ * eg. `I_Incrementable& next_` or lambdas capturing `this`. When
+ * such a chain is copied or moved, the copy still points into the
+ * original, so each chain must stay where it was constructed:
+ *
+ *   original: [ hh ]<------[ mm ]<------[ ss ]
+ *                ^ ^
+ *                |  \_________________
+ *                |                    \
+ *   copy:     [ hh ]  [ mm ]-------+  [ ss ]------+  (copies still
+ *                                                    link to the
+ *                                                    original!)
+ *
+ * Here the link from a stage to the next is its POSITION: the
+ * stages are an array (lowest first) and a carry from `values_[i]`
+ * goes to `values_[i+1]`, with the limits being template arguments.
+ * So a chain holds nothing but its values, is trivially copyable
+ * and can be stored contiguously (eg. in a `std::vector`), copied
+ * with `memcpy` and written to or read from files as is.
+*/
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+// Chain of stages with the given limits (lowest stage first),
+// where a limit of 0 means "unlimited" (only useful at the top).
+// When the top stage overflows the chain either starts over
+// (`wrap_at_top`) or sticks at its maximum, like a `FlexCounter`
+// chain (see Step-09) whose top stage's `next_` returns `false`.
+template<typename T, T... Limits>
+class PositionalChain {
+public:
+    static constexpr std::size_t N = sizeof...(Limits);
+    explicit PositionalChain(bool wrap_at_top = true)
+        : wrap_at_top_{wrap_at_top}
+    {}
+    // returns false when sticking at the maximum (nothing changed)
+    bool incr();
+    T get_value(std::size_t stage) const { return values_[stage]; }
+    static constexpr T get_limit(std::size_t stage) { return limits_[stage]; }
+private:
+    static constexpr T limits_[N] = {Limits...};
+    std::array<T, N> values_{};
+    bool wrap_at_top_;
+};
+
+template<typename T, T... Limits>
+bool PositionalChain<T, Limits...>::incr() {
+    for (std::size_t i = 0; i < N; ++i)
+        if (limits_[i] == 0 || values_[i] + 1 < limits_[i]) {
+            ++values_[i];
+            for (std::size_t k = 0; k < i; ++k) values_[k] = T{};
+            return true;
+        }
+    if (!wrap_at_top_) return false;
+    values_ = {};
+    return true;
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC types of counters built from these classes
+
+#include <cstdint>
+#include <string>
+
+class HhmmssChain {
+public:
+    HhmmssChain(bool true_or_false)
+        : chain_{true_or_false}
+    {}
+    void incr() { chain_.incr(); }
+    std::string to_string() const;
+private:
+    PositionalChain<std::uint8_t, 60, 60, 24> chain_;
+};
+
+std::string HhmmssChain::to_string() const {
+    std::string result;
+    for (std::size_t i = 3; i-- > 0; ) {
+        auto const v = chain_.get_value(i);
+        result += char('0' + v / 10);
+        result += char('0' + v % 10);
+        if (i > 0) result += ':';
+    }
+    return result;
+}
+
+#include <iomanip>
+#include <sstream>
+
+class OperationHoursMeter {
+public:
+    void incr() { chain_.incr(); }
+    std::string to_string() const;
+private:
+    PositionalChain<unsigned, 10, 60, 60, 24, 0> chain_;
+};
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << chain_.get_value(4)
+       << 'd'
+       << std::setw(2) << chain_.get_value(3)
+       << ':'
+       << std::setw(2) << chain_.get_value(2)
+       << ':'
+       << std::setw(2) << chain_.get_value(1)
+       << '.'
+       << std::setw(1) << chain_.get_value(0);
+    return os.str();
+}
+
+static_assert(std::is_trivially_copyable_v<HhmmssChain>);
+static_assert(std::is_trivially_copyable_v<OperationHoursMeter>);
+static_assert(sizeof(HhmmssChain) == 4);
+
+// the linked chain of Step-09 for comparison
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+class LinkedHhmmssChain {
+public:
+    LinkedHhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    void incr() { ss.incr(); }
+    std::string to_string() const;
+private:
+    FlexCounter<int, 24> hh;
+    FlexCounter<int, 60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{[this]{ return mm.incr(); }};
+};
+
+std::string LinkedHhmmssChain::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << std::setw(2) << hh.get_value()
+       << ':'
+       << std::setw(2) << mm.get_value()
+       << ':'
+       << std::setw(2) << ss.get_value();
+    return os.str();
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+template<typename Chain>
+void copy_and_tick(char const* name) {
+    Chain original{true};
+    for (int i = 0; i < 59; ++i) original.incr();
+    Chain copy{original};
+    for (int i = 0; i < 2; ++i) copy.incr();
+    std::cout << std::setw(19) << std::left << name << std::right
+              << " original " << original.to_string()
+              << ", copy " << copy.to_string() << std::endl;
+}
+
+void test_copies() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::cout << "59 ticks, copy, 2 more ticks of the copy:" << std::endl;
+    copy_and_tick<LinkedHhmmssChain>("LinkedHhmmssChain");
+    copy_and_tick<HhmmssChain>("HhmmssChain");
+}
+
+void test_chains() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    HhmmssChain resetting{true}, sticky{false};
+    LinkedHhmmssChain linked_resetting{true}, linked_sticky{false};
+    unsigned errors = 0;
+    for (int i = 0; i < 24*60*60 + 100; ++i) {
+        resetting.incr(); sticky.incr();
+        linked_resetting.incr(); linked_sticky.incr();
+        errors += (resetting.to_string() != linked_resetting.to_string())
+                + (sticky.to_string() != linked_sticky.to_string());
+    }
+    OperationHoursMeter meter{};
+    for (int i = 0; i < 3*24*60*60*10 + 12345; ++i) meter.incr();
+    std::cout << "resetting " << resetting.to_string() << ", sticky "
+              << sticky.to_string() << ", " << errors
+              << " differences to the linked chain; " << meter.to_string()
+              << std::endl;
+}
+
+// many meters in a vector vs. individually allocated linked chains
+void benchmark_fleet(std::size_t n, int rounds) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::mt19937 rng{41};
+    std::vector<std::unique_ptr<LinkedHhmmssChain>> linked{};
+    for (std::size_t i = 0; i < n; ++i)
+        linked.push_back(std::make_unique<LinkedHhmmssChain>(true));
+    std::shuffle(linked.begin(), linked.end(), rng);  // as after churn
+    std::vector<HhmmssChain> contiguous(n, HhmmssChain{true});
+    auto const t0 = clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (auto& m : linked) m->incr();
+    auto const t1 = clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (auto& m : contiguous) m.incr();
+    auto const t2 = clock::now();
+    std::vector<HhmmssChain> snapshot(n, HhmmssChain{true});
+    std::memcpy(snapshot.data(), contiguous.data(), n * sizeof(HhmmssChain));
+    auto const t3 = clock::now();
+    for (auto& m : contiguous) m.incr();        // snapshot unaffected
+    std::cout << n << " chains, " << rounds << " ticks each:\n"
+              << "  linked, heap allocated (" << sizeof(LinkedHhmmssChain)
+              << " bytes + allocation): " << ms(t1 - t0) << "ms\n"
+              << "  positional, contiguous (" << sizeof(HhmmssChain)
+              << " bytes): " << ms(t2 - t1) << "ms\n"
+              << "  memcpy snapshot: " << ms(t3 - t2) << "ms, "
+              << snapshot.back().to_string() << " (now "
+              << contiguous.back().to_string() << ", linked "
+              << linked.back()->to_string() << ")" << std::endl;
+}
+
+int main() {
+    test_copies();
+    test_chains();
+    benchmark_fleet(1'000'000, 100);
+}
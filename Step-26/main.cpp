@@ -0,0 +1,340 @@
+/*
+ * ===============================================================
+ * Mergeable Replica Meters (a Grow-Only Counter CRDT)
+ * ===============================================================
+ * When the same logical meter is ticked on several nodes, adding
+ * up the snapshots of all nodes counts twice whenever a snapshot
+ * is delivered twice (eg. on a retry). Here each replica keeps the
+ * tick total of EVERY replica it knows of, but only increments its
+ * own entry. Two states are merged by taking the maximum of each
+ * entry, which is idempotent, commutative and associative, so the
+ * same message may arrive any number of times, in any order:
+ *
+ *           replica A       replica B       replica C
+ *   A's:    [A:7 B:3 C:0]   [A:5 B:4 C:2]   [A:0 B:0 C:9]
+ *                 \              |
+ *                  \-- merge = max per entry --\
+ *                                              v
+ *   C's after merging both:                [A:7 B:4 C:9]  = 20
+ *
+ * Instead of full states only DELTAS are shipped: the entries that
+ * changed since the last delta was taken, encoded as varints. As
+ * each entry is a TOTAL (not an increment), a delta that is lost
+ * only delays the update until the replica's entry changes again.
+*/
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+class ReplicaMeter {
+public:
+    using ReplicaId = std::uint32_t;
+    explicit ReplicaMeter(ReplicaId id) : id_{id} {}
+    void incr() { advance(1); }
+    void advance(std::uint64_t n);
+    std::uint64_t get_ticks() const;     // of all replicas
+    void merge(ReplicaMeter const& other);
+    // entries changed since the prior call (or all, if `full`),
+    // encoded as a string of bytes; applied by `merge_encoded`
+    std::string take_delta(bool full = false);
+    void merge_encoded(std::string_view delta);
+    ReplicaId get_id() const { return id_; }
+private:
+    void merge_entry(ReplicaId id, std::uint64_t ticks);
+    ReplicaId const id_;
+    std::map<ReplicaId, std::uint64_t> totals_{};
+    std::map<ReplicaId, std::uint64_t> changed_{};
+};
+
+void ReplicaMeter::advance(std::uint64_t n) {
+    auto const total = (totals_[id_] += n);
+    changed_[id_] = total;
+}
+
+std::uint64_t ReplicaMeter::get_ticks() const {
+    std::uint64_t sum = 0;
+    for (auto const& [id, ticks] : totals_) sum += ticks;
+    return sum;
+}
+
+void ReplicaMeter::merge_entry(ReplicaId id, std::uint64_t ticks) {
+    auto& mine = totals_[id];
+    if (ticks > mine) {
+        mine = ticks;
+        changed_[id] = ticks;         // passed on with the next delta
+    }
+}
+
+void ReplicaMeter::merge(ReplicaMeter const& other) {
+    for (auto const& [id, ticks] : other.totals_)
+        merge_entry(id, ticks);
+}
+
+namespace {
+    void put_varint(std::string& out, std::uint64_t v) {
+        while (v >= 0x80) {
+            out += char(v | 0x80);
+            v >>= 7;
+        }
+        out += char(v);
+    }
+    // returns false if `in` ends within the varint
+    bool get_varint(std::string_view& in, std::uint64_t& v) {
+        v = 0;
+        for (unsigned shift = 0; !in.empty() && shift < 64; shift += 7) {
+            auto const byte = std::uint8_t(in.front());
+            in.remove_prefix(1);
+            v |= std::uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+}
+
+#include <stdexcept>
+
+// encoding: entries := (replica id, total)*, ids ascending and
+// stored as the difference to the prior one
+std::string ReplicaMeter::take_delta(bool full) {
+    std::string result{};
+    ReplicaId prior = 0;
+    for (auto const& [id, ticks] : full ? totals_ : changed_) {
+        put_varint(result, id - prior);
+        put_varint(result, ticks);
+        prior = id;
+    }
+    changed_.clear();
+    return result;
+}
+
+void ReplicaMeter::merge_encoded(std::string_view delta) {
+    std::uint64_t id = 0;
+    while (!delta.empty()) {
+        std::uint64_t step, ticks;
+        if (!get_varint(delta, step) || !get_varint(delta, ticks))
+            throw std::invalid_argument{"truncated replica meter delta"};
+        if (step > UINT32_MAX - id)
+            throw std::invalid_argument{"replica id out of range in delta"};
+        id += step;
+        merge_entry(ReplicaId(id), ticks);
+    }
+}
+
+// above: helper class to MERGE counters of several replicas
+// ---------------------------------------------------------------
+// below: a SPECIFIC way to render it, and a simulation
+
+#include <iomanip>
+#include <sstream>
+
+std::string to_string(ReplicaMeter const& meter) {
+    auto const value = meter.get_ticks();
+    std::ostringstream os{};
+    os.fill('0');
+    os << value / (24*60*60*10)
+       << 'd'
+       << std::setw(2) << (value % (24*60*60*10) / (60*60*10))
+       << ':'
+       << std::setw(2) << (value % (60*60*10) / (60*10))
+       << ':'
+       << std::setw(2) << (value % (60*10) / 10)
+       << '.'
+       << std::setw(1) << (value % 10);
+    return os.str();
+}
+
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// delivers byte strings to replicas (by index)
+class Transport {
+public:
+    virtual ~Transport() =default;
+    virtual void send(std::size_t to, std::string const& message) = 0;
+    virtual bool receive(std::size_t at, std::string& message) = 0;
+};
+
+class QueueTransport : public Transport {
+public:
+    explicit QueueTransport(std::size_t replicas) : queues_(replicas) {}
+    void send(std::size_t to, std::string const& message) override {
+        queues_[to].push_back(message);
+    }
+    bool receive(std::size_t at, std::string& message) override {
+        if (queues_[at].empty()) return false;
+        message = std::move(queues_[at].front());
+        queues_[at].pop_front();
+        return true;
+    }
+private:
+    std::vector<std::deque<std::string>> queues_;
+};
+
+// one file per message in a per-replica directory (eg. as if the
+// directory were shared or synchronized between nodes)
+class FileTransport : public Transport {
+public:
+    FileTransport(std::filesystem::path dir, std::size_t replicas);
+    ~FileTransport() override { std::filesystem::remove_all(dir_); }
+    void send(std::size_t to, std::string const& message) override;
+    bool receive(std::size_t at, std::string& message) override;
+private:
+    std::filesystem::path inbox(std::size_t r) const {
+        return dir_ / ("replica-" + std::to_string(r));
+    }
+    std::filesystem::path const dir_;
+    unsigned long sequence_ = 0;
+};
+
+FileTransport::FileTransport(std::filesystem::path dir, std::size_t replicas)
+    : dir_{std::move(dir)}
+{
+    std::filesystem::remove_all(dir_);
+    for (std::size_t r = 0; r < replicas; ++r)
+        std::filesystem::create_directories(inbox(r));
+}
+
+void FileTransport::send(std::size_t to, std::string const& message) {
+    auto const name = inbox(to) / (std::to_string(++sequence_) + ".delta");
+    std::ofstream{name, std::ios::binary} << message;
+}
+
+bool FileTransport::receive(std::size_t at, std::string& message) {
+    for (auto const& entry : std::filesystem::directory_iterator{inbox(at)}) {
+        {
+            std::ifstream in{entry.path(), std::ios::binary};
+            message.assign(std::istreambuf_iterator<char>{in}, {});
+        }
+        std::filesystem::remove(entry.path());
+        return true;                 // in no particular order
+    }
+    return false;
+}
+
+#include <iostream>
+#include <random>
+
+struct Faults {
+    double drop;         // probability a message is lost
+    double duplicate;    // ... is delivered twice (a retry)
+};
+
+void simulate(char const* name, Transport& net, std::size_t replicas,
+              int rounds, Faults faults) {
+    std::mt19937 rng{42};
+    std::vector<ReplicaMeter> meters{};
+    for (std::size_t r = 0; r < replicas; ++r)
+        meters.emplace_back(ReplicaMeter::ReplicaId(r + 1));
+    std::uniform_int_distribution<int> ticks{0, 600};
+    std::uniform_int_distribution<std::size_t> peer{0, replicas - 1};
+    std::bernoulli_distribution dropped{faults.drop}, duplicated{faults.duplicate};
+    std::uint64_t sent = 0, bytes = 0, expected = 0;
+    auto deliver = [&](std::size_t to, std::string const& message) {
+        ++sent;
+        bytes += message.size();
+        if (dropped(rng)) return;
+        net.send(to, message);
+        if (duplicated(rng)) net.send(to, message);
+    };
+    for (int round = 0; round < rounds; ++round) {
+        for (std::size_t r = 0; r < replicas; ++r) {
+            auto const n = ticks(rng);
+            meters[r].advance(n);
+            expected += n;
+            auto const delta = meters[r].take_delta();
+            for (int k = 0; k < 2; ++k) {           // gossip to 2 peers
+                auto to = peer(rng);
+                if (to != r) deliver(to, delta);
+            }
+        }
+        for (std::size_t r = 0; r < replicas; ++r) {
+            std::string message;
+            while (net.receive(r, message)) meters[r].merge_encoded(message);
+        }
+    }
+    // anti-entropy until all agree: full states around a ring
+    auto converged = [&] {
+        for (auto const& m : meters)
+            if (m.get_ticks() != meters.front().get_ticks()) return false;
+        return true;
+    };
+    int sync_rounds = 0;
+    while (!converged() && sync_rounds < 10) {
+        ++sync_rounds;
+        for (std::size_t pass = 0; pass < 2; ++pass)
+            for (std::size_t r = 0; r < replicas; ++r) {
+                net.send((r + 1) % replicas, meters[r].take_delta(true));
+                std::string message;
+                while (net.receive((r + 1) % replicas, message))
+                    meters[(r + 1) % replicas].merge_encoded(message);
+            }
+    }
+    std::cout << std::setw(6) << std::left << name << std::right
+              << replicas << " replicas, " << rounds << " rounds, "
+              << sent << " deltas (" << double(bytes) / sent
+              << " bytes each), " << sync_rounds << " sync round(s): "
+              << to_string(meters.front()) << ' '
+              << (converged() && meters.front().get_ticks() == expected
+                  ? "all agree, exact" : "WRONG")
+              << std::endl;
+}
+
+// for comparison: each replica reports its ticks since the prior
+// report, all reports are summed up - retries count twice
+void simulate_resumming(std::size_t replicas, int rounds, Faults faults) {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> ticks{0, 600};
+    std::bernoulli_distribution duplicated{faults.duplicate};
+    std::uint64_t expected = 0, summed = 0;
+    for (int round = 0; round < rounds; ++round)
+        for (std::size_t r = 0; r < replicas; ++r) {
+            auto const n = std::uint64_t(ticks(rng));
+            expected += n;
+            summed += duplicated(rng) ? 2 * n : n;
+        }
+    std::cout << "re-summing reports with the same retries: "
+              << summed - expected << " ticks counted twice ("
+              << 100.0 * (summed - expected) / expected << "%)" << std::endl;
+}
+
+void test_merge() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    ReplicaMeter a{1}, b{2}, c{3};
+    a.advance(7); b.advance(4); c.advance(9);
+    b.merge_encoded(a.take_delta());
+    auto const from_b = b.take_delta();
+    c.merge_encoded(from_b);
+    c.merge_encoded(from_b);                 // twice: no effect
+    a.merge(c); a.merge(b); b.merge(c); b.merge(a);
+    std::cout << "a " << a.get_ticks() << ", b " << b.get_ticks()
+              << ", c " << c.get_ticks() << " (expected 20 for all), "
+              << "delta of b: " << from_b.size() << " bytes" << std::endl;
+    // an id of 2^32 (a varint of 5 bytes) does not fit a ReplicaId
+    std::string const corrupt{"\x80\x80\x80\x80\x10\x01", 6};
+    try {
+        c.merge_encoded(corrupt);
+        std::cout << "corrupt delta merged" << std::endl;
+    }
+    catch (std::invalid_argument const& e) {
+        std::cout << "corrupt delta rejected: " << e.what() << std::endl;
+    }
+}
+
+void test_replicas() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Faults const faults{0.1, 0.1};
+    QueueTransport queues{16};
+    simulate("queue", queues, 16, 5'000, faults);
+    FileTransport files{"replicas.tmp", 8};
+    simulate("files", files, 8, 200, faults);
+    simulate_resumming(16, 5'000, faults);
+}
+
+int main() {
+    test_merge();
+    test_replicas();
+}
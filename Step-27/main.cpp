@@ -0,0 +1,267 @@
+/*
+ * ===============================================================
+ * Tracing Ticks, Overflows and Callbacks as a Timeline
+ * ===============================================================
+ * This version is basically the same as Step-09 but (optionally)
+ * records when each tick starts and ends, when a stage overflows
+ * and how long the call of the next stage (`next_()`) takes. The
+ * events go into a fixed size ring buffer per thread, which only
+ * this thread writes to (so no locking is needed) and in which the
+ * newest events overwrite the oldest ones, like a flight recorder:
+ *
+ *   thread 1: [B tick][B next_() ss][i overflow ss][E ...][E tick]..
+ *   thread 2: [B tick][E tick][B tick] ...
+ *        |
+ *        v  write_chrome_trace()
+ *   {"traceEvents":[{"name":"tick","ph":"B","ts":12.345,"tid":1},
+ *                   ...]}
+ *
+ * The output is in the Chrome Trace Event format, which can be
+ * opened with chrome://tracing or https://ui.perfetto.dev to show
+ * the nested events of each thread on a timeline.
+*/
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Tracer {
+public:
+    struct Event {
+        std::int64_t ns;             // since the tracer's epoch
+        char const* name;            // must be a string literal
+        char phase;                  // 'B'egin, 'E'nd or 'i'nstant
+    };
+    static constexpr std::size_t CAPACITY = 1 << 16;   // per thread
+    static void enable(bool on = true) { enabled_.store(on, std::memory_order_relaxed); }
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void record(char const* name, char phase);
+    template<typename Out>
+    static void write_chrome_trace(Out& out);
+private:
+    struct Buffer {
+        explicit Buffer(unsigned tid) : tid{tid} {}
+        unsigned const tid;
+        std::atomic<std::uint64_t> written{0};
+        std::array<Event, CAPACITY> events;
+    };
+    static Buffer& this_thread_buffer();
+    inline static std::atomic<bool> enabled_{false};
+    inline static std::chrono::steady_clock::time_point const epoch_ =
+        std::chrono::steady_clock::now();
+    inline static std::mutex registry_mutex_{};       // not per event
+    inline static std::vector<std::unique_ptr<Buffer>> registry_{};
+};
+
+Tracer::Buffer& Tracer::this_thread_buffer() {
+    thread_local Buffer* buffer = [] {
+        std::lock_guard<std::mutex> lock{registry_mutex_};
+        auto const tid = unsigned(registry_.size() + 1);
+        registry_.push_back(std::make_unique<Buffer>(tid));
+        return registry_.back().get();
+    }();
+    return *buffer;
+}
+
+void Tracer::record(char const* name, char phase) {
+    auto& buffer = this_thread_buffer();
+    auto const n = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[n % CAPACITY] = {
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count(),
+        name, phase};
+    buffer.written.store(n + 1, std::memory_order_release);
+}
+
+// RAII begin and end event (when the tracer is enabled)
+class TraceScope {
+public:
+    explicit TraceScope(char const* name)
+        : name_{Tracer::enabled() ? name : nullptr}
+    {
+        if (name_) Tracer::record(name_, 'B');
+    }
+    TraceScope(TraceScope const&) =delete;
+    TraceScope& operator=(TraceScope const&) =delete;
+    ~TraceScope() { if (name_) Tracer::record(name_, 'E'); }
+private:
+    char const* const name_;
+};
+
+inline void trace_instant(char const* name) {
+    if (Tracer::enabled()) Tracer::record(name, 'i');
+}
+
+#include <cstdio>
+
+// To be called while the traced threads do not record any more
+// (eg. after they finished or with the tracer disabled); of each
+// thread the newest CAPACITY events are written.
+template<typename Out>
+void Tracer::write_chrome_trace(Out& out) {
+    std::lock_guard<std::mutex> lock{registry_mutex_};
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char const* separator = "\n";
+    char ts[32];
+    for (auto const& buffer : registry_) {
+        auto const written = buffer->written.load(std::memory_order_acquire);
+        auto const first = (written > CAPACITY) ? written - CAPACITY : 0;
+        unsigned depth = 0;          // skip ends of overwritten begins
+        for (auto i = first; i < written; ++i) {
+            auto const& e = buffer->events[i % CAPACITY];
+            if (e.phase == 'E' && depth == 0) continue;
+            depth += (e.phase == 'B');
+            depth -= (e.phase == 'E');
+            std::snprintf(ts, sizeof ts, "%lld.%03lld",
+                          static_cast<long long>(e.ns / 1000),
+                          static_cast<long long>(e.ns % 1000));
+            out << separator << "{\"name\":\"" << e.name
+                << "\",\"ph\":\"" << e.phase << "\",\"ts\":" << ts
+                << ",\"pid\":1,\"tid\":" << buffer->tid
+                << (e.phase == 'i' ? ",\"s\":\"t\"}" : "}");
+            separator = ",\n";
+        }
+    }
+    out << "\n]}\n";
+}
+
+#include <functional>
+#include <limits>
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    // `name` must be a string literal (it is used for tracing)
+    FlexCounter(char const* name, std::function<bool()> next)
+        : name_{name}, next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    char const* const name_;
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    trace_instant(name_);                    // the overflow
+    bool carried;
+    {
+        TraceScope call{"next_()"};
+        carried = next_ && next_();
+    }
+    if (carried) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <string>
+
+class HhmmssChain {
+public:
+    HhmmssChain(bool true_or_false)
+        : hh{"overflow hh", [=]{ return true_or_false; }}
+    {}
+    void incr() {
+        TraceScope tick{"tick"};
+        ss.incr();
+    }
+    std::string to_string() const;
+private:
+    FlexCounter<int, 24> hh;
+    FlexCounter<int, 60> mm{"overflow mm", [this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{"overflow ss", [this]{ return mm.incr(); }};
+};
+
+std::string HhmmssChain::to_string() const {
+    std::string result;
+    if (hh.get_value() < 10) result += "0";
+    result += std::to_string(hh.get_value());
+    result += ":";
+    if (mm.get_value() < 10) result += "0";
+    result += std::to_string(mm.get_value());
+    result += ":";
+    if (ss.get_value() < 10) result += "0";
+    result += std::to_string(ss.get_value());
+    return result;
+}
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+void test_trace(char const* path) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Tracer::enable();
+    std::vector<std::thread> threads{};
+    std::vector<std::string> results(3);
+    for (int t = 0; t < 3; ++t)
+        threads.emplace_back([t, &results] {
+            HhmmssChain chain{t != 1};
+            // a callback that sometimes takes long (stall)
+            for (int i = 0; i < 24*60*60 + 3; ++i) {
+                chain.incr();
+                if (i % (60*60) == 0) {
+                    TraceScope slow{"slow callback"};
+                    std::this_thread::sleep_for(std::chrono::microseconds{50});
+                }
+            }
+            results[std::size_t(t)] = chain.to_string();
+        });
+    for (auto& t : threads) t.join();
+    Tracer::enable(false);
+    std::ofstream out{path};
+    Tracer::write_chrome_trace(out);
+    std::cout << "chains at " << results[0] << ", " << results[1]
+              << " (sticky), " << results[2] << "; trace of the newest "
+              << Tracer::CAPACITY << " events per thread in " << path
+              << std::endl;
+}
+
+#include <iomanip>
+
+void benchmark_overhead(int n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto ns = [n](clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    HhmmssChain off{true}, on{true};
+    auto const t0 = clock::now();
+    for (int i = 0; i < n; ++i) off.incr();
+    auto const t1 = clock::now();
+    Tracer::enable();
+    for (int i = 0; i < n; ++i) on.incr();
+    Tracer::enable(false);
+    auto const t2 = clock::now();
+    std::cout << std::setprecision(3) << "per tick: " << ns(t1 - t0)
+              << "ns disabled, " << ns(t2 - t1) << "ns enabled" << std::endl;
+}
+
+#include <filesystem>
+
+// the trace goes to argv[1], by default into the temp directory
+// (NOT into the Step folder, where it would end up in the sources)
+int main(int argc, char* argv[]) {
+    auto const path = (argc > 1) ? std::filesystem::path{argv[1]}
+                    : std::filesystem::temp_directory_path() / "trace.json";
+    test_trace(path.c_str());
+    benchmark_overhead(10'000'000);
+}
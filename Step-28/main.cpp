@@ -0,0 +1,310 @@
+/*
+ * ===============================================================
+ * Runtime Configured Radices on Precompiled Engines
+ * ===============================================================
+ * Chains with limits known at compile time (eg. Step-05/07/09) are
+ * fast, but a layout read from a configuration file must fall back
+ * to limits held in data members (eg. Step-01/04). Here a factory
+ * takes the radices at run time (lowest stage first, an unlimited
+ * top stage is always added) and picks an ENGINE for them:
+ *
+ *   make_meter({10,60,60,24})
+ *      |
+ *      |  matches a known layout?
+ *      +---- yes ---> FixedEngine<10,60,60,24>  (limits compiled in,
+ *      |                                         carries unrolled)
+ *      +---- no ----> RuntimeEngine             (limits in a vector)
+ *
+ *   Meter (the handle)
+ *   +-----------------+      +-------------------+
+ *   | engine_ --------+----->| I_Engine          |  ONE virtual call
+ *   +-----------------+      | +incr() +advance()|  per tick for the
+ *                            +-------------------+  whole chain
+ *
+ * Either way the caller only sees the `Meter` handle, and all the
+ * stages are ticked within the single call of the engine.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+class I_Engine {
+public:
+    virtual ~I_Engine() =default;
+    virtual void incr() =0;
+    virtual void advance(std::uint64_t n) =0;
+    virtual std::size_t stages() const =0;          // incl. the top
+    virtual std::uint64_t get_value(std::size_t stage) const =0;
+    virtual std::uint64_t get_limit(std::size_t stage) const =0;
+    virtual bool is_specialized() const =0;
+};
+
+template<unsigned... Limits>
+class FixedEngine final : public I_Engine {
+public:
+    static constexpr std::size_t N = sizeof...(Limits);
+    static bool matches(std::vector<unsigned> const& radices) {
+        return radices == std::vector<unsigned>{Limits...};
+    }
+    void incr() override;
+    void advance(std::uint64_t n) override;
+    std::size_t stages() const override { return N + 1; }
+    std::uint64_t get_value(std::size_t stage) const override {
+        return stage < N ? values_[stage] : top_;
+    }
+    std::uint64_t get_limit(std::size_t stage) const override {
+        return stage < N ? limits_[stage] : 0;
+    }
+    bool is_specialized() const override { return true; }
+private:
+    static constexpr unsigned limits_[N] = {Limits...};
+    unsigned values_[N] = {};
+    std::uint64_t top_ = 0;
+};
+
+template<unsigned... Limits>
+void FixedEngine<Limits...>::incr() {
+    for (std::size_t i = 0; i < N; ++i) {     // unrolled, as N and
+        if (++values_[i] < limits_[i]) return;  // the limits are
+        values_[i] = 0;                         // constants
+    }
+    ++top_;
+}
+
+template<unsigned... Limits>
+void FixedEngine<Limits...>::advance(std::uint64_t n) {
+    for (std::size_t i = 0; i < N; ++i) {
+        auto const sum = values_[i] + n % limits_[i];
+        values_[i] = unsigned(sum % limits_[i]);
+        n = n / limits_[i] + sum / limits_[i];
+        if (n == 0) return;
+    }
+    top_ += n;
+}
+
+class RuntimeEngine final : public I_Engine {
+public:
+    explicit RuntimeEngine(std::vector<unsigned> radices)
+        : limits_{std::move(radices)}, values_(limits_.size())
+    {}
+    void incr() override;
+    void advance(std::uint64_t n) override;
+    std::size_t stages() const override { return limits_.size() + 1; }
+    std::uint64_t get_value(std::size_t stage) const override {
+        return stage < values_.size() ? values_[stage] : top_;
+    }
+    std::uint64_t get_limit(std::size_t stage) const override {
+        return stage < limits_.size() ? limits_[stage] : 0;
+    }
+    bool is_specialized() const override { return false; }
+private:
+    std::vector<unsigned> const limits_;
+    std::vector<unsigned> values_;
+    std::uint64_t top_ = 0;
+};
+
+void RuntimeEngine::incr() {
+    for (std::size_t i = 0; i < limits_.size(); ++i) {
+        if (++values_[i] < limits_[i]) return;
+        values_[i] = 0;
+    }
+    ++top_;
+}
+
+void RuntimeEngine::advance(std::uint64_t n) {
+    for (std::size_t i = 0; i < limits_.size(); ++i) {
+        auto const sum = values_[i] + n % limits_[i];
+        values_[i] = unsigned(sum % limits_[i]);
+        n = n / limits_[i] + sum / limits_[i];
+        if (n == 0) return;
+    }
+    top_ += n;
+}
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+class Meter {
+public:
+    explicit Meter(std::unique_ptr<I_Engine> engine)
+        : engine_{std::move(engine)}
+    {}
+    void incr() { engine_->incr(); }
+    void advance(std::uint64_t n) { engine_->advance(n); }
+    std::size_t stages() const { return engine_->stages(); }
+    std::uint64_t get_value(std::size_t stage) const { return engine_->get_value(stage); }
+    bool is_specialized() const { return engine_->is_specialized(); }
+    // top stage first, lower stages zero padded, eg. "3:04:05:06:7"
+    std::string to_string() const;
+private:
+    std::unique_ptr<I_Engine> engine_;
+};
+
+std::string Meter::to_string() const {
+    auto result = std::to_string(engine_->get_value(stages() - 1));
+    for (std::size_t i = stages() - 1; i-- > 0; ) {
+        auto const digits = std::to_string(engine_->get_value(i));
+        auto width = std::size_t{1};
+        for (auto max = engine_->get_limit(i) - 1; max >= 10; max /= 10)
+            ++width;
+        result += ':';
+        result.append(width - std::min(width, digits.size()), '0');
+        result += digits;
+    }
+    return result;
+}
+
+namespace detail {
+    template<typename... Engines>
+    std::unique_ptr<I_Engine> make_engine(std::vector<unsigned> const& radices) {
+        std::unique_ptr<I_Engine> result{};
+        ((!result && Engines::matches(radices)
+            ? (result = std::make_unique<Engines>(), 0) : 0), ...);
+        return result;
+    }
+}
+
+// the layouts precompiled as FixedEngines (the common ones)
+using KnownEngines = std::tuple<
+    FixedEngine<10, 60, 60, 24>,        // tenths, seconds ... days
+    FixedEngine<60, 60, 24>,            // seconds ... days
+    FixedEngine<1000, 60, 60, 24>       // milliseconds ... days
+>;
+
+template<typename Known = KnownEngines>
+Meter make_meter(std::vector<unsigned> const& radices) {
+    for (auto const radix : radices)
+        if (radix < 2) throw std::invalid_argument{"radix must be 2 or more"};
+    auto engine = std::apply([&radices](auto... known) {
+        return detail::make_engine<decltype(known)...>(radices);
+    }, Known{});
+    if (!engine) engine = std::make_unique<RuntimeEngine>(radices);
+    return Meter{std::move(engine)};
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC uses with layouts known only at run time
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+std::string to_string(std::vector<unsigned> const& radices) {
+    std::ostringstream os{};
+    os << '{';
+    for (std::size_t i = 0; i < radices.size(); ++i)
+        os << (i ? "," : "") << radices[i];
+    os << '}';
+    return os.str();
+}
+
+void test_layouts() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::vector<std::vector<unsigned>> const layouts{
+        {10, 60, 60, 24}, {60, 60, 24}, {1000, 60, 60, 24},
+        {10, 60, 60}, {7, 24}, {2, 2, 2, 2, 2},
+    };
+    std::mt19937_64 rng{44};
+    for (auto const& radices : layouts) {
+        auto meter = make_meter(radices);
+        // the reference: the total decomposed by the radices
+        std::uint64_t total = 0;
+        auto expected = [&radices, &total](std::size_t stage) {
+            auto rest = total;
+            for (std::size_t i = 0; i < stage; ++i) rest /= radices[i];
+            return (stage < radices.size()) ? rest % radices[stage] : rest;
+        };
+        unsigned errors = (meter.stages() != radices.size() + 1);
+        for (int i = 0; i < 2'000; ++i) {
+            auto const n = rng() % (i % 2 ? 100 : 100'000'000);
+            if (n < 100)
+                for (auto k = 0u; k < n; ++k) meter.incr();
+            else
+                meter.advance(n);
+            total += n;
+            for (std::size_t s = 0; s < meter.stages(); ++s)
+                errors += (meter.get_value(s) != expected(s));
+        }
+        std::cout << std::setw(18) << std::left << to_string(radices)
+                  << std::right << (meter.is_specialized() ? " fixed  " : " runtime")
+                  << ' ' << meter.to_string() << ", " << errors
+                  << " differences" << std::endl;
+    }
+    try { make_meter({10, 1, 60}); }
+    catch (std::invalid_argument const& ex) {
+        std::cout << "{10,1,60}: " << ex.what() << std::endl;
+    }
+}
+
+void benchmark_engines(std::vector<unsigned> const& radices,
+                       std::size_t meters, int ticks) {
+    std::cout << "== " << __func__ << ' ' << to_string(radices)
+              << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto ns = [meters](clock::duration d, int rounds) {
+        return std::chrono::duration<double, std::nano>(d).count()
+             / (double(meters) * rounds);
+    };
+    auto const jumps = ticks / 10;
+    std::vector<Meter> fixed{}, generic{};
+    for (std::size_t i = 0; i < meters; ++i) {
+        fixed.push_back(make_meter(radices));
+        generic.push_back(Meter{std::make_unique<RuntimeEngine>(radices)});
+    }
+    auto const t0 = clock::now();
+    for (int t = 0; t < ticks; ++t)
+        for (auto& m : fixed) m.incr();
+    auto const t1 = clock::now();
+    for (int t = 0; t < ticks; ++t)
+        for (auto& m : generic) m.incr();
+    auto const t2 = clock::now();
+    std::uint64_t step = 12345;
+    for (int t = 0; t < jumps; ++t, step = step * 5 % 1'000'003)
+        for (auto& m : fixed) m.advance(step);
+    auto const t3 = clock::now();
+    step = 12345;
+    for (int t = 0; t < jumps; ++t, step = step * 5 % 1'000'003)
+        for (auto& m : generic) m.advance(step);
+    auto const t4 = clock::now();
+    auto const kind = fixed.front().is_specialized() ? "fixed" : "runtime";
+    std::cout << std::setprecision(3) << "per incr():    "
+              << ns(t1 - t0, ticks) << "ns via the factory (" << kind
+              << "), " << ns(t2 - t1, ticks) << "ns with the runtime engine\n"
+              << "per advance(): " << ns(t3 - t2, jumps) << "ns via the factory ("
+              << kind << "), " << ns(t4 - t3, jumps) << "ns with the runtime engine ("
+              << (fixed.back().to_string() == generic.back().to_string()
+                  ? "same" : "DIFFERENT") << " results)" << std::endl;
+}
+
+#include <climits>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    test_layouts();
+    // a layout "from the configuration": the command line, if given
+    std::vector<unsigned> radices{};
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::size_t used = 0;
+            auto const radix = std::stoul(argv[i], &used);
+            if (argv[i][used] != '\0' || radix > UINT_MAX)
+                throw std::invalid_argument{argv[i]};
+            radices.push_back(unsigned(radix));
+        }
+        if (radices.empty()) radices = {10, 60, 60, 24};
+        make_meter(radices);
+    }
+    catch (std::exception const& ex) {      // invalid_argument, out_of_range
+        std::cerr << "usage: " << argv[0] << " [radix...]  (lowest stage"
+                     " first, each 2 or more): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    benchmark_engines(radices, 1'000, 100'000);
+}
@@ -0,0 +1,287 @@
+/*
+ * ===============================================================
+ * Transactional Batch Increments over Many Chains
+ * ===============================================================
+ * When several meters must be advanced TOGETHER (eg. all meters of
+ * a machine by the same batch of ticks) and one of them throws, eg.
+ * because its top stage must not overflow, the meters advanced
+ * before are already changed. Here a `Transaction` first collects
+ * the increments, then computes ALL the new states (by bulk
+ * arithmetic, not tick by tick) and only if that succeeds for all
+ * chains, publishes them, which cannot fail any more:
+ *
+ *   tx.add(a, 100); tx.add(b, 7); tx.add(a, 5); tx.add(c, 9)
+ *        |
+ *   commit():
+ *     1. prepare  a: 105 -> new state  }  may throw (eg. overflow
+ *                 b:   7 -> new state  }  of a top stage), nothing
+ *                 c:   9 -> new state  }  is changed up to here
+ *     2. publish  a = ..., b = ..., c = ... (noexcept)
+ *
+ * So either all chains advance, or (if an exception leaves commit)
+ * none does - the strong exception guarantee.
+*/
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+// what happens when the top stage overflows
+enum class AtTop { Wrap, Stick, Throw };
+
+// Chain of stages with the given limits (lowest stage first),
+// where a limit of 0 means "unlimited" (only useful at the top).
+template<AtTop policy, unsigned... Limits>
+class Chain {
+public:
+    static constexpr std::size_t N = sizeof...(Limits);
+    using State = std::array<unsigned, N>;
+    void incr() { state_ = advanced(state_, 1); }
+    void advance(std::uint64_t n) { state_ = advanced(state_, n); }
+    State const& get_state() const { return state_; }
+    static constexpr unsigned get_limit(std::size_t stage) { return limits_[stage]; }
+    // the state `n` ticks after `s` (may throw if policy is Throw)
+    static State advanced(State s, std::uint64_t n);
+    void publish(State const& s) noexcept { state_ = s; }
+private:
+    static constexpr unsigned limits_[N] = {Limits...};
+    State state_{};
+};
+
+template<AtTop policy, unsigned... Limits>
+auto Chain<policy, Limits...>::advanced(State s, std::uint64_t n) -> State {
+    for (std::size_t i = 0; i < N && n > 0; ++i) {
+        if (limits_[i] == 0) {                   // "unlimited", but
+            if (n <= UINT_MAX - s[i]) {          // up to UINT_MAX only
+                s[i] += unsigned(n);
+                return s;
+            }
+            s[i] = unsigned(s[i] + n);           // as for AtTop::Wrap
+            break;
+        }
+        auto const sum = s[i] + n % limits_[i];
+        s[i] = unsigned(sum % limits_[i]);
+        n = n / limits_[i] + sum / limits_[i];
+    }
+    if (n == 0 || policy == AtTop::Wrap) return s;
+    if (policy == AtTop::Throw) throw std::overflow_error{"top stage overflow"};
+    for (std::size_t i = 0; i < N; ++i)          // AtTop::Stick (at
+        s[i] = limits_[i] - 1;                   // UINT_MAX if unlimited)
+    return s;
+}
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+class Transaction {
+public:
+    // stages `n` more ticks for `chain` (which must outlive commit),
+    // adding to the same chain again is merged when committing
+    template<typename C>
+    void add(C& chain, std::uint64_t n);
+    // all or nothing; empty afterwards, unless an exception leaves
+    // (then all chains and the staged increments are unchanged)
+    void commit();
+    std::size_t size() const { return entries_.size(); }  // adds so far
+private:
+    static constexpr std::size_t MAX_STAGES = 8;
+    using Staged = std::array<unsigned, MAX_STAGES>;
+    struct Entry {
+        void* chain;
+        std::uint64_t n;
+        void (*prepare)(void const* chain, std::uint64_t n, Staged& out);
+        void (*publish)(void* chain, Staged const& s) noexcept;
+    };
+    std::vector<Entry> entries_{};
+    std::vector<Staged> staged_{};
+};
+
+template<typename C>
+void Transaction::add(C& chain, std::uint64_t n) {
+    static_assert(C::N <= MAX_STAGES, "too many stages");
+    entries_.push_back({&chain, n,
+        [](void const* c, std::uint64_t n, Staged& out) {
+            auto const s = C::advanced(static_cast<C const*>(c)->get_state(), n);
+            for (std::size_t i = 0; i < C::N; ++i) out[i] = s[i];
+        },
+        [](void* c, Staged const& s) noexcept {
+            typename C::State state;
+            for (std::size_t i = 0; i < C::N; ++i) state[i] = s[i];
+            static_cast<C*>(c)->publish(state);
+        }});
+}
+
+void Transaction::commit() {
+    // merge all adds to the same chain, sorted by address so this is
+    // O(k log k) for k adds; the sum is checked before anything is
+    // merged, so that an exception leaves the same increments staged
+    auto const by_chain = [](Entry const& a, Entry const& b) {
+        return std::less<void*>{}(a.chain, b.chain);
+    };
+    std::sort(entries_.begin(), entries_.end(), by_chain);
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+        sum = (i > 0 && entries_[i - 1].chain == entries_[i].chain) ? sum : 0;
+        if (sum + entries_[i].n < sum) throw std::overflow_error{"too many ticks"};
+        sum += entries_[i].n;
+    }
+    std::size_t m = 0;
+    for (std::size_t i = 0; i < entries_.size(); ++i)
+        if (m > 0 && entries_[m - 1].chain == entries_[i].chain)
+            entries_[m - 1].n += entries_[i].n;
+        else
+            entries_[m++] = entries_[i];
+    entries_.resize(m);
+    staged_.resize(entries_.size());             // may throw: nothing
+    for (std::size_t i = 0; i < entries_.size(); ++i)   // changed yet
+        entries_[i].prepare(entries_[i].chain, entries_[i].n, staged_[i]);
+    for (std::size_t i = 0; i < entries_.size(); ++i)   // cannot fail
+        entries_[i].publish(entries_[i].chain, staged_[i]);
+    entries_.clear();
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC types of counters built from these classes
+
+#include <string>
+
+// top stage first, each padded to the digits of its limit
+template<typename C>
+std::string to_string(C const& chain) {
+    std::string result{};
+    auto const& s = chain.get_state();
+    for (std::size_t i = C::N; i-- > 0; ) {
+        auto const digits = std::to_string(s[i]);
+        std::size_t width = 1;
+        for (auto max = C::get_limit(i) - 1; C::get_limit(i) && max >= 10; max /= 10)
+            ++width;
+        if (width > digits.size()) result.append(width - digits.size(), '0');
+        result += digits;
+        if (i > 0) result += (i == 1 && C::get_limit(0) == 10) ? '.' : ':';
+    }
+    return result;
+}
+
+using OperationHoursMeter = Chain<AtTop::Wrap, 10, 60, 60, 24, 0>;
+using StickyHhmmss = Chain<AtTop::Stick, 60, 60, 24>;   // Step-09 false
+using ThrowingHhmmss = Chain<AtTop::Throw, 60, 60, 24>;
+
+#include <iostream>
+
+struct Machine {
+    OperationHoursMeter hours{};
+    StickyHhmmss sticky{};
+    ThrowingHhmmss throwing{};
+    void show(char const* when) const {
+        std::cout << when << ": " << to_string(hours) << "  "
+                  << to_string(sticky) << "  " << to_string(throwing)
+                  << std::endl;
+    }
+};
+
+void test_all_or_nothing() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Machine one_by_one{};
+    Machine transactional{};
+    Transaction tx{};
+    for (auto* m : {&one_by_one, &transactional}) {
+        tx.add(m->hours, 12*60*60*10);
+        tx.add(m->sticky, 12*60*60);
+        tx.add(m->throwing, 12*60*60);
+    }
+    tx.commit();
+    one_by_one.show("after 12h  ");
+    // 13 more hours: the first meters advance, then the last throws
+    try {
+        one_by_one.hours.advance(13*60*60*10);
+        one_by_one.sticky.advance(13*60*60);
+        one_by_one.throwing.advance(13*60*60);
+    }
+    catch (std::overflow_error const& ex) {
+        one_by_one.show("one by one ");
+        std::cout << "  (" << ex.what() << ", the others advanced anyway)"
+                  << std::endl;
+    }
+    tx.add(transactional.hours, 6*60*60*10);
+    tx.add(transactional.sticky, 13*60*60);
+    tx.add(transactional.throwing, 6*60*60);
+    tx.add(transactional.hours, 7*60*60*10);     // merged with the 6h
+    tx.add(transactional.throwing, 7*60*60);
+    try { tx.commit(); }
+    catch (std::overflow_error const& ex) {
+        transactional.show("transaction");
+        std::cout << "  (" << ex.what() << ", nothing changed)" << std::endl;
+    }
+}
+
+// the "unlimited" top stage holds at most UINT_MAX, beyond which
+// the policy applies as for any other top stage
+void test_unlimited_top() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    std::uint64_t const n = 10ull * UINT_MAX + 7;     // top +UINT_MAX
+    Chain<AtTop::Wrap, 10, 0> wrapping{};
+    Chain<AtTop::Stick, 10, 0> sticky{};
+    Chain<AtTop::Throw, 10, 0> throwing{};
+    wrapping.advance(25);
+    sticky.advance(25);
+    throwing.advance(25);
+    wrapping.advance(n);
+    sticky.advance(n);
+    std::cout << "wrap: " << wrapping.get_state()[1] << '|'
+              << wrapping.get_state()[0] << ", stick: "
+              << sticky.get_state()[1] << '|' << sticky.get_state()[0];
+    Transaction tx{};
+    tx.add(throwing, n);
+    try { tx.commit(); std::cout << ", throw: no exception (WRONG)"; }
+    catch (std::overflow_error const& ex) {
+        std::cout << ", throw: " << ex.what() << " at "
+                  << throwing.get_state()[1] << '|'
+                  << throwing.get_state()[0];
+    }
+    std::cout << std::endl;
+}
+
+#include <chrono>
+#include <random>
+
+void benchmark_batches(std::size_t meters, int batches) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    std::vector<OperationHoursMeter> by_tx(meters), by_tick(meters);
+    std::mt19937 rng{45};
+    std::uniform_int_distribution<unsigned> ticks{0, 600};
+    std::vector<unsigned> batch(meters);
+    Transaction tx{};
+    clock::duration tx_time{}, tick_time{};
+    for (int b = 0; b < batches; ++b) {
+        for (auto& n : batch) n = ticks(rng);
+        auto const t0 = clock::now();
+        for (std::size_t i = 0; i < meters; ++i) tx.add(by_tx[i], batch[i]);
+        tx.commit();
+        auto const t1 = clock::now();
+        for (std::size_t i = 0; i < meters; ++i)
+            for (auto k = batch[i]; k > 0; --k) by_tick[i].incr();
+        auto const t2 = clock::now();
+        tx_time += t1 - t0;
+        tick_time += t2 - t1;
+    }
+    std::size_t differences = 0;
+    for (std::size_t i = 0; i < meters; ++i)
+        differences += (by_tx[i].get_state() != by_tick[i].get_state());
+    std::cout << meters << " meters, " << batches << " batches of up to 600 ticks:"
+              << " transactions " << ms(tx_time) << "ms, tick by tick "
+              << ms(tick_time) << "ms, " << differences << " differences ("
+              << to_string(by_tx.front()) << ")" << std::endl;
+}
+
+int main() {
+    test_unlimited_top();
+    test_all_or_nothing();
+    benchmark_batches(1'000, 100);
+}
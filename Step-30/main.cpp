@@ -0,0 +1,346 @@
+/*
+ * ===============================================================
+ * Latency Histograms and a Strict Mode for Real-Time Ticking
+ * ===============================================================
+ * The average time of a tick (as measured in prior Steps) tells
+ * little about the WORST case, which matters if the ticking thread
+ * has real-time requirements. Here the duration of each single
+ * `incr()` and each iteration of a tick loop is recorded in a
+ * histogram with logarithmic buckets, each split linearly (as in
+ * HdrHistogram), so that any percentile is known within ~3%:
+ *
+ *   value (cycles)  0 1 ... 63 | 64 66 ... 126 | 128 132 ... 252 | ...
+ *   bucket width    1          | 2             | 4               | ...
+ *
+ * Sources of unbounded latency in the meters of prior Steps are
+ * heap allocation (in `std::function`, `ostringstream` ...), the
+ * throwing of exceptions and `std::flush`. The STRICT meter below
+ * has none of these: it does not allocate (which is checked by
+ * counting all calls of `operator new`), cannot throw (`noexcept`
+ * is checked at compile time) and its carry path is bounded by the
+ * fixed number of stages.
+*/
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// counts of values (eg. durations in timer ticks) in buckets of
+// relative width 2^-SUB_BITS, without any allocation
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    void record(std::uint64_t value) noexcept;
+    std::uint64_t get_count() const { return count_; }
+    std::uint64_t get_max() const { return max_; }
+    // an upper bound of the given percentile (0..100)
+    std::uint64_t percentile(double p) const;
+private:
+    static constexpr std::size_t LINEAR = std::size_t{2} << SUB_BITS;
+    static constexpr std::size_t BUCKETS = LINEAR + (63 - SUB_BITS) * (LINEAR / 2);
+    static std::size_t bucket_of(std::uint64_t v) noexcept;
+    static std::uint64_t upper_bound(std::size_t bucket);
+    std::array<std::uint64_t, BUCKETS> counts_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+std::size_t LatencyHistogram::bucket_of(std::uint64_t v) noexcept {
+    if (v < LINEAR) return std::size_t(v);
+    auto const msb = 63u - unsigned(__builtin_clzll(v));
+    auto const shift = msb - SUB_BITS;
+    auto const top = v >> shift;          // in [LINEAR/2, LINEAR)
+    return LINEAR + (shift - 1) * (LINEAR / 2) + (top - LINEAR / 2);
+}
+
+std::uint64_t LatencyHistogram::upper_bound(std::size_t bucket) {
+    if (bucket < LINEAR) return bucket;
+    auto const shift = (bucket - LINEAR) / (LINEAR / 2) + 1;
+    auto const top = (bucket - LINEAR) % (LINEAR / 2) + LINEAR / 2;
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t value) noexcept {
+    ++counts_[bucket_of(value)];
+    ++count_;
+    if (value > max_) max_ = value;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    auto const wanted = std::uint64_t(p / 100.0 * double(count_) + 0.999999);
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < BUCKETS; ++b)
+        if ((seen += counts_[b]) >= wanted && seen > 0)
+            return upper_bound(b) < max_ ? upper_bound(b) : max_;
+    return max_;
+}
+
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// cheap timestamps: the CPU's time stamp counter where available
+// (a few ns to read), else the steady clock
+struct TickTimer {
+#if defined(__x86_64__) || defined(__i386__)
+    static std::uint64_t now() noexcept { return __rdtsc(); }
+#else
+    static std::uint64_t now() noexcept {
+        return std::uint64_t(std::chrono::steady_clock::now()
+                             .time_since_epoch().count());
+    }
+#endif
+    static double ns_per_tick();          // measured once
+};
+
+double TickTimer::ns_per_tick() {
+    static double const result = [] {
+        using clock = std::chrono::steady_clock;
+        auto const c0 = clock::now();
+        auto const t0 = now();
+        while (clock::now() - c0 < std::chrono::milliseconds{50}) {}
+        auto const t1 = now();
+        auto const c1 = clock::now();
+        return std::chrono::duration<double, std::nano>(c1 - c0).count()
+             / double(t1 - t0);
+    }();
+    return result;
+}
+
+#include <climits>
+#include <functional>
+
+// the meter of Step-07 (std::function links, iostream rendering)
+
+class BasicCounter {
+public:
+    unsigned get_value() const { return value_; }
+    void incr() { ++value_; }
+    void reset() { value_ = 0;}
+private:
+    unsigned value_ = 0;
+};
+
+template<unsigned limit_ = UINT_MAX>
+class LimitCounter : public BasicCounter {
+public:
+    LimitCounter() =default;
+    static constexpr unsigned get_limit() { return limit_; }
+    void incr();
+private:
+    virtual void overflowed() { /*empty*/ }
+};
+
+template<unsigned limit_>
+void LimitCounter<limit_>::incr() {
+    BasicCounter::incr();
+    if (get_value() == limit_) {
+        reset();
+        overflowed();
+    }
+}
+
+template<unsigned limit_>
+class OverflowCounter : public LimitCounter<limit_> {
+public:
+    OverflowCounter(std::function<void()> next)
+        : next_{next}
+    {}
+private:
+    void overflowed() override;
+    std::function<void()> next_;
+};
+
+template<unsigned limit_>
+void OverflowCounter<limit_>::overflowed() {
+    if (next_) next_();
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: SPECIFIC types of counters, the strict one without them
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+class OperationHoursMeter {
+public:
+    OperationHoursMeter();
+    std::string to_string() const;
+    void incr();
+private:
+    BasicCounter days_;
+    OverflowCounter<24> hours_;
+    OverflowCounter<60> minutes_;
+    OverflowCounter<60> seconds_;
+    OverflowCounter<10> sec_10th_;
+};
+
+OperationHoursMeter::OperationHoursMeter()
+    : days_{}
+    , hours_{[this]{ days_.incr(); }}
+    , minutes_{[this]{ hours_.incr(); }}
+    , seconds_{[this]{ minutes_.incr(); }}
+    , sec_10th_{[this]{ seconds_.incr(); }}
+{}
+
+std::string OperationHoursMeter::to_string() const {
+    std::ostringstream os{};
+    os.fill('0');
+    os << days_.get_value()
+       << 'd'
+       << std::setw(2) << hours_.get_value()
+       << ':'
+       << std::setw(2) << minutes_.get_value()
+       << ':'
+       << std::setw(2) << seconds_.get_value()
+       << '.'
+       << std::setw(1) << sec_10th_.get_value();
+    return os.str();
+}
+
+void OperationHoursMeter::incr() {
+    sec_10th_.incr();
+}
+
+// No allocation, no exceptions, at most five compare-and-stores
+// per tick; renders into a caller supplied buffer.
+class StrictOperationHoursMeter {
+public:
+    static constexpr std::size_t MAX_TEXT = 10 + 11;
+    void incr() noexcept;
+    std::size_t render(char* out) const noexcept;
+private:
+    std::uint32_t days_ = 0;
+    std::uint8_t hours_ = 0, minutes_ = 0, seconds_ = 0, sec_10th_ = 0;
+};
+
+void StrictOperationHoursMeter::incr() noexcept {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    ++days_;
+}
+
+std::size_t StrictOperationHoursMeter::render(char* out) const noexcept {
+    char digits[10];
+    auto days = days_;
+    int n = 0;
+    do { digits[n++] = char('0' + days % 10); days /= 10; } while (days);
+    char* p = out;
+    while (n > 0) *p++ = digits[--n];
+    auto two = [&p](unsigned v) {
+        *p++ = char('0' + v / 10);
+        *p++ = char('0' + v % 10);
+    };
+    *p++ = 'd';
+    two(hours_);
+    *p++ = ':';
+    two(minutes_);
+    *p++ = ':';
+    two(seconds_);
+    *p++ = '.';
+    *p++ = char('0' + sec_10th_);
+    return std::size_t(p - out);
+}
+
+static_assert(noexcept(std::declval<StrictOperationHoursMeter&>().incr()));
+static_assert(noexcept(std::declval<StrictOperationHoursMeter const&>().render(nullptr)));
+static_assert(std::is_nothrow_default_constructible_v<StrictOperationHoursMeter>);
+static_assert(std::is_trivially_copyable_v<StrictOperationHoursMeter>);
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// every allocation of the program is counted
+std::atomic<unsigned long long> allocations{0};
+
+void* operator new(std::size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+void report(char const* name, LatencyHistogram const& h,
+            unsigned long long allocs) {
+    auto const ns = TickTimer::ns_per_tick();
+    std::cout << std::setw(22) << std::left << name << std::right
+              << std::fixed << std::setprecision(0);
+    std::pair<char const*, double> const percentiles[] = {
+        {"p50", 50.0}, {"p99", 99.0}, {"p99.9", 99.9}, {"p99.99", 99.99},
+    };
+    for (auto const& [label, p] : percentiles)
+        std::cout << ' ' << label << ' ' << std::setw(5) << h.percentile(p) * ns;
+    std::cout << "  max " << std::setw(7) << h.get_max() * ns << " ns, "
+              << allocs << " allocations" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+}
+
+template<typename F>
+LatencyHistogram measure(unsigned long n, F&& f, unsigned long long& allocs) {
+    LatencyHistogram h{};
+    auto const before = allocations.load();
+    for (unsigned long i = 0; i < n; ++i) {
+        auto const t0 = TickTimer::now();
+        f(i);
+        auto const t1 = TickTimer::now();
+        h.record(t1 - t0);
+    }
+    allocs = allocations.load() - before;
+    return h;
+}
+
+// a tick loop renders the meter once per second (every 10 ticks)
+bool verify_bounds(unsigned long n, double bound_ns) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    unsigned long long allocs;
+    auto const overhead = measure(n, [](unsigned long) {}, allocs);
+    report("(timer only)", overhead, allocs);
+
+    OperationHoursMeter meter{};
+    report("incr()", measure(n, [&](unsigned long) { meter.incr(); }, allocs), allocs);
+    std::ofstream out{"/dev/null"};
+    report("tick loop", measure(n, [&](unsigned long i) {
+        meter.incr();
+        if (i % 10 == 0) out << meter.to_string() << '\n' << std::flush;
+    }, allocs), allocs);
+
+    StrictOperationHoursMeter strict{};
+    report("strict incr()", measure(n, [&](unsigned long) { strict.incr(); }, allocs), allocs);
+    static char text[StrictOperationHoursMeter::MAX_TEXT + 1];
+    std::size_t chars = 0;
+    auto const strict_loop = measure(n, [&](unsigned long i) {
+        strict.incr();
+        if (i % 10 == 0) chars += strict.render(text);
+    }, allocs);
+    report("strict tick loop", strict_loop, allocs);
+    auto const p9999 = double(strict_loop.percentile(99.99)) * TickTimer::ns_per_tick();
+    bool const ok = (allocs == 0 && p9999 <= bound_ns);
+    std::cout << "strict tick loop p99.99 " << p9999 << "ns, bound "
+              << bound_ns << "ns, allocations " << allocs << ": "
+              << (ok ? "PASS" : "FAIL") << " (" << chars << " chars rendered)"
+              << std::endl;
+    std::cout << "(the max. includes preemption by the OS, which only a"
+                 " real-time kernel can bound)" << std::endl;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    auto const bound_ns = (argc > 1) ? std::atof(argv[1]) : 1000.0;
+    return verify_bounds(10'000'000, bound_ns) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
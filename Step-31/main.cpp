@@ -0,0 +1,249 @@
+/*
+ * ===============================================================
+ * Sticky Chains that Remember Being Saturated
+ * ===============================================================
+ * This version is basically the same as Step-09 but a sticky chain
+ * (ie. one whose top stage's `next_()` returns `false`) does not
+ * ask its next stage again and again once it got stuck. Otherwise
+ * EVERY further tick of `HhmmssChain{false}` at 23:59:59 walks up
+ * through two `std::function` calls just to learn that nothing can
+ * be changed:
+ *
+ *   before:  ss.incr() -> next_() -> mm.incr() -> next_() -> hh.incr()
+ *              false  <-----------     false   <-----------   false
+ *
+ *   now:     ss.incr(): saturated_ ? return false   (one flag, which
+ *                                                    is set once when
+ *                                                    next_() refuses)
+ *
+ * The saturated state is only left by an explicit `reset()`. As
+ * this treats a refusing `next_()` as PERMANENT, it must be chosen
+ * explicitly (`FlexCounter<T, N, true>`); by default a counter asks
+ * `next_()` on every overflow as in Step-09, eg. for a gate that
+ * refuses only for some time.
+*/
+#include <functional>
+#include <limits>
+
+// with `latching` once `next_()` refused it is not asked again
+template<typename T, T N = std::numeric_limits<T>::max(),
+         bool latching = false>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool is_saturated() const { return saturated_; }  // if latching
+    bool incr();
+    void reset() {
+        value_ = value_type{};
+        saturated_ = false;
+    }
+private:
+    value_type value_ = value_type{};
+    bool saturated_ = false;
+    std::function<bool()> next_;
+};
+
+template<typename T, T N, bool latching>
+bool FlexCounter<T, N, latching>::incr() {
+    if (latching && saturated_) return false;
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    saturated_ = latching;      // stays so until reset()
+    return false;
+}
+
+// above: helper classes to built many DIFFERENT kinds of counters
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter built from these classes
+
+#include <string>
+
+class HhmmssChain {
+public:
+    HhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    void incr() { ss.incr(); }
+    bool is_saturated() const { return ss.is_saturated(); }
+    void reset() { hh.reset(); mm.reset(); ss.reset(); }
+    std::string to_string() const;
+private:
+    // `hh.next_` always returns the same, so latching is fine
+    FlexCounter<int, 24, true> hh;
+    FlexCounter<int, 60, true> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60, true> ss{[this]{ return mm.incr(); }};
+};
+
+std::string HhmmssChain::to_string() const {
+    std::string result;
+    if (hh.get_value() < 10) result += "0";
+    result += std::to_string(hh.get_value());
+    result += ":";
+    if (mm.get_value() < 10) result += "0";
+    result += std::to_string(mm.get_value());
+    result += ":";
+    if (ss.get_value() < 10) result += "0";
+    result += std::to_string(ss.get_value());
+    return result;
+}
+
+// the classes of Step-09 for comparison
+namespace step09 {
+
+template<typename T, T N = std::numeric_limits<T>::max()>
+class FlexCounter {
+public:
+    using value_type = T;
+    static const value_type MAX = N;
+    FlexCounter(std::function<bool()> next)
+        : next_{next}
+    {}
+    value_type get_value() const { return value_; }
+    bool incr();
+private:
+    value_type value_ = value_type{};
+    std::function<bool()> next_;
+};
+
+template<typename T, T N>
+bool FlexCounter<T, N>::incr() {
+    auto const lv = value_ + 1;
+    if (lv < MAX) {
+        value_ = lv;
+        return true;
+    }
+    if (next_ && next_()) {
+        value_ = value_type{};
+        return true;
+    }
+    return false;
+}
+
+class HhmmssChain {
+public:
+    HhmmssChain(bool true_or_false)
+        : hh{[=]{return true_or_false; }}
+    {}
+    void incr() { ss.incr(); }
+    std::string to_string() const {
+        auto two = [](int v) { return std::string(v < 10, '0') + std::to_string(v); };
+        return two(hh.get_value()) + ":" + two(mm.get_value()) + ":"
+             + two(ss.get_value());
+    }
+private:
+    FlexCounter<int, 24> hh;
+    FlexCounter<int, 60> mm{[this]{ return hh.incr(); }};
+    FlexCounter<int, 60> ss{[this]{ return mm.incr(); }};
+};
+
+} // namespace step09
+
+#include <iostream>
+
+void test_sticky_counter(int n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    FlexCounter<int, 3, true> sticky{[]{ return false; }};
+    for (int i = 0; i < n; ++i) {
+        std::cout << sticky.get_value()
+                  << (sticky.is_saturated() ? "s " : " ") << std::flush;
+        sticky.incr();
+    }
+    sticky.reset();
+    std::cout << "| reset | ";
+    for (int i = 0; i < 3; ++i) {
+        std::cout << sticky.get_value() << ' ';
+        sticky.incr();
+    }
+    std::cout << std::endl;
+    // not latching: a gate refusing for a while is asked again
+    bool open = false;
+    int carries = 0;
+    FlexCounter<int, 3> gated{[&]{ carries += open; return open; }};
+    for (int i = 0; i < 4; ++i) gated.incr();
+    open = true;
+    gated.incr();
+    std::cout << "gated: " << gated.get_value() << " after " << carries
+              << " carry once open"
+              << (gated.is_saturated() ? " (saturated - WRONG)" : "")
+              << std::endl;
+}
+
+void test_hhmmss_chain(int n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    HhmmssChain resetting{true}, sticky{false};
+    step09::HhmmssChain old_resetting{true}, old_sticky{false};
+    unsigned errors = 0;
+    for (int i = 0; i < n; ++i) {
+        resetting.incr(); sticky.incr();
+        old_resetting.incr(); old_sticky.incr();
+        errors += (resetting.to_string() != old_resetting.to_string())
+                + (sticky.to_string() != old_sticky.to_string());
+    }
+    std::cout << "resetting " << resetting.to_string() << ", sticky "
+              << sticky.to_string() << (sticky.is_saturated() ? " (saturated)" : "")
+              << ", " << errors << " differences to Step-09" << std::endl;
+    sticky.reset();
+    sticky.incr();
+    std::cout << "sticky after reset and one tick: " << sticky.to_string()
+              << std::endl;
+}
+
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+template<typename Chain>
+double ns_per_tick(std::vector<Chain>& chains, int ticks) {
+    using clock = std::chrono::steady_clock;
+    auto const t0 = clock::now();
+    for (int t = 0; t < ticks; ++t)
+        for (auto& c : chains) c.incr();
+    auto const t1 = clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count()
+         / (double(chains.size()) * ticks);
+}
+
+template<typename Chain>
+std::vector<Chain> make_chains(std::size_t n, bool true_or_false, int ticks) {
+    std::vector<Chain> chains{};
+    chains.reserve(n);     // never reallocated, as `this` is captured
+    for (std::size_t i = 0; i < n; ++i) {
+        chains.emplace_back(true_or_false);
+        for (int t = 0; t < ticks; ++t) chains.back().incr();
+    }
+    return chains;
+}
+
+void benchmark_saturated(std::size_t n, int ticks) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    auto old_stuck = make_chains<step09::HhmmssChain>(n, false, 24*60*60);
+    auto new_stuck = make_chains<HhmmssChain>(n, false, 24*60*60);
+    auto old_live = make_chains<step09::HhmmssChain>(n, true, 12*60*60);
+    auto new_live = make_chains<HhmmssChain>(n, true, 12*60*60);
+    std::cout << std::setprecision(3) << "per tick, saturated: "
+              << ns_per_tick(old_stuck, ticks) << "ns Step-09, "
+              << ns_per_tick(new_stuck, ticks) << "ns now\n"
+              << "per tick, live:      "
+              << ns_per_tick(old_live, ticks) << "ns Step-09, "
+              << ns_per_tick(new_live, ticks) << "ns now ("
+              << new_stuck.back().to_string() << ", "
+              << new_live.back().to_string() << ")" << std::endl;
+}
+
+int main() {
+    test_sticky_counter(6);
+    test_hhmmss_chain(24*60*60 + 333);
+    benchmark_saturated(1'000, 10'000);
+}
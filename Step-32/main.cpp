@@ -0,0 +1,394 @@
+/*
+ * ===============================================================
+ * A Registry for Millions of Named Meters
+ * ===============================================================
+ * All prior Steps create a single meter on the stack. Here MANY
+ * meters are created, looked up by name or by a numeric id, and
+ * owned by a `MeterRegistry`:
+ *
+ *   index_ (open addressing, linear probing)
+ *   +-------+-------+-------+-------+-------+
+ *   | tag|4 |   0   | tag|1 | tag|2 |   0   |  0 = empty, else upper
+ *   +-------+-------+-------+-------+-------+  32 bits of the hash and
+ *       |               |       |              the slot number (+1)
+ *       v               v       v
+ *   blocks of meters (never moved)          blocks of keys
+ *   +----+----+----+----+----+ ...          +----------------------+
+ *   | m0 | m1 | m2 | m3 | m4 |              | id, or name (offset  |
+ *   +----+----+----+----+----+              | into a name arena)   |
+ *     ^                                     +----------------------+
+ *     +-- handles point here, stay valid while the registry lives
+ *
+ * Meters and keys are allocated in large blocks that are filled
+ * one after the other, so creating a meter does not allocate (most
+ * of the time) and iterating over all meters is a sequential scan.
+ * When the index grows only the index entries move, the meters
+ * stay where they are.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+struct MeterKey {
+    std::string_view name;            // empty if created by id
+    std::uint64_t id;
+};
+
+template<typename Meter>
+class MeterRegistry {
+public:
+    static constexpr std::size_t BLOCK = std::size_t{1} << 16;     // meters
+    static constexpr std::size_t NAME_BLOCK = std::size_t{1} << 20; // chars
+    class Handle {
+    public:
+        Meter& operator*() const { return *meter_; }
+        Meter* operator->() const { return meter_; }
+    private:
+        friend class MeterRegistry;
+        explicit Handle(Meter* meter) : meter_{meter} {}
+        Meter* meter_;
+    };
+    // the meter of this name or id, created if not yet there
+    Handle get(std::string_view name);
+    Handle get(std::uint64_t id);
+    // null if there is no such meter
+    Meter* find(std::string_view name) const;
+    Meter* find(std::uint64_t id) const;
+    void reserve(std::size_t meters);
+    std::size_t size() const { return size_; }
+    // calls `f(MeterKey, Meter&)` in the order of creation
+    template<typename F>
+    void for_each(F f);
+private:
+    struct Key {
+        std::uint64_t value;          // the id, or the name's offset
+        std::uint32_t length;         // 0 for an id
+    };
+    static std::uint64_t mix(std::uint64_t h) {
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        return h ^ (h >> 33);
+    }
+    static std::uint64_t hash(std::string_view name) {
+        std::uint64_t h = 0xcbf29ce484222325ull;          // FNV-1a
+        for (char c : name) h = (h ^ std::uint8_t(c)) * 0x100000001b3ull;
+        return mix(h);
+    }
+    static std::uint64_t hash(std::uint64_t id) { return mix(id ^ 0x9e3779b97f4a7c15ull); }
+    std::string_view name_of(Key const& k) const {
+        return {&names_[k.value / NAME_BLOCK][k.value % NAME_BLOCK], k.length};
+    }
+    Key& key_at(std::size_t slot) { return keys_[slot / BLOCK][slot % BLOCK]; }
+    Key const& key_at(std::size_t slot) const { return keys_[slot / BLOCK][slot % BLOCK]; }
+    Meter& meter_at(std::size_t slot) const { return meters_[slot / BLOCK][slot % BLOCK]; }
+    std::uint64_t hash_of(Key const& k) const {
+        return k.length ? hash(name_of(k)) : hash(k.value);
+    }
+    // the slot of an existing key or SIZE_MAX; `pos` is where to
+    // insert if not found
+    template<typename Equal>
+    std::size_t lookup(std::uint64_t h, Equal equal, std::size_t& pos) const;
+    std::size_t new_slot(Key const& k, std::uint64_t h, std::size_t pos);
+    void rehash(std::size_t capacity);
+    std::uint64_t store_name(std::string_view name);
+    std::vector<std::unique_ptr<Meter[]>> meters_{};
+    std::vector<std::unique_ptr<Key[]>> keys_{};
+    std::vector<std::unique_ptr<char[]>> names_{};
+    std::size_t names_used_ = NAME_BLOCK;      // in the last block
+    std::vector<std::uint64_t> index_ = std::vector<std::uint64_t>(16);
+    std::size_t size_ = 0;
+};
+
+template<typename Meter>
+template<typename Equal>
+std::size_t MeterRegistry<Meter>::lookup(std::uint64_t h, Equal equal,
+                                         std::size_t& pos) const {
+    auto const mask = index_.size() - 1;
+    auto const tag = h >> 32;
+    for (pos = h & mask; index_[pos] != 0; pos = (pos + 1) & mask)
+        if ((index_[pos] >> 32) == tag) {
+            auto const slot = std::size_t(index_[pos] & 0xffff'ffff) - 1;
+            if (equal(key_at(slot))) return slot;
+        }
+    return SIZE_MAX;
+}
+
+template<typename Meter>
+std::uint64_t MeterRegistry<Meter>::store_name(std::string_view name) {
+    if (name.size() > NAME_BLOCK)
+        throw std::invalid_argument{"meter name too long"};
+    if (NAME_BLOCK - names_used_ < name.size()) {
+        names_.emplace_back(new char[NAME_BLOCK]);
+        names_used_ = 0;
+    }
+    std::memcpy(&names_.back()[names_used_], name.data(), name.size());
+    auto const offset = (names_.size() - 1) * NAME_BLOCK + names_used_;
+    names_used_ += name.size();
+    return offset;
+}
+
+template<typename Meter>
+std::size_t MeterRegistry<Meter>::new_slot(Key const& k, std::uint64_t h,
+                                           std::size_t pos) {
+    if ((size_ + 1) * 4 > index_.size() * 3) {         // load <= 75%
+        rehash(index_.size() * 2);
+        for (pos = h & (index_.size() - 1); index_[pos] != 0;
+             pos = (pos + 1) & (index_.size() - 1)) {}
+    }
+    if (size_ % BLOCK == 0) {
+        // default (not value) initialized: keys are written before use
+        meters_.emplace_back(new Meter[BLOCK]);
+        keys_.emplace_back(new Key[BLOCK]);
+    }
+    auto const slot = size_++;
+    key_at(slot) = k;
+    index_[pos] = (h >> 32 << 32) | (slot + 1);
+    return slot;
+}
+
+template<typename Meter>
+void MeterRegistry<Meter>::rehash(std::size_t capacity) {
+    std::vector<std::uint64_t> index(capacity);
+    auto const mask = capacity - 1;
+    for (std::size_t slot = 0; slot < size_; ++slot) {
+        auto const h = hash_of(key_at(slot));
+        auto pos = h & mask;
+        while (index[pos] != 0) pos = (pos + 1) & mask;
+        index[pos] = (h >> 32 << 32) | (slot + 1);
+    }
+    index_.swap(index);
+}
+
+template<typename Meter>
+void MeterRegistry<Meter>::reserve(std::size_t meters) {
+    std::size_t capacity = index_.size();
+    while (meters * 4 > capacity * 3) capacity *= 2;
+    if (capacity > index_.size()) rehash(capacity);
+    meters_.reserve((meters + BLOCK - 1) / BLOCK);
+    keys_.reserve((meters + BLOCK - 1) / BLOCK);
+}
+
+template<typename Meter>
+auto MeterRegistry<Meter>::get(std::string_view name) -> Handle {
+    if (name.empty()) throw std::invalid_argument{"empty meter name"};
+    auto const h = hash(name);
+    std::size_t pos;
+    auto slot = lookup(h, [&](Key const& k) {
+        return k.length == name.size() && name_of(k) == name;
+    }, pos);
+    if (slot == SIZE_MAX) {
+        Key const k{store_name(name), std::uint32_t(name.size())};
+        slot = new_slot(k, h, pos);
+    }
+    return Handle{&meter_at(slot)};
+}
+
+template<typename Meter>
+auto MeterRegistry<Meter>::get(std::uint64_t id) -> Handle {
+    auto const h = hash(id);
+    std::size_t pos;
+    auto slot = lookup(h, [id](Key const& k) {
+        return k.length == 0 && k.value == id;
+    }, pos);
+    if (slot == SIZE_MAX) slot = new_slot(Key{id, 0}, h, pos);
+    return Handle{&meter_at(slot)};
+}
+
+template<typename Meter>
+Meter* MeterRegistry<Meter>::find(std::string_view name) const {
+    std::size_t pos;
+    auto const slot = lookup(hash(name), [&](Key const& k) {
+        return k.length == name.size() && name_of(k) == name;
+    }, pos);
+    return slot == SIZE_MAX ? nullptr : &meter_at(slot);
+}
+
+template<typename Meter>
+Meter* MeterRegistry<Meter>::find(std::uint64_t id) const {
+    std::size_t pos;
+    auto const slot = lookup(hash(id), [id](Key const& k) {
+        return k.length == 0 && k.value == id;
+    }, pos);
+    return slot == SIZE_MAX ? nullptr : &meter_at(slot);
+}
+
+template<typename Meter>
+template<typename F>
+void MeterRegistry<Meter>::for_each(F f) {
+    for (std::size_t slot = 0; slot < size_; ++slot) {
+        auto const& k = key_at(slot);
+        f(k.length ? MeterKey{name_of(k), 0} : MeterKey{{}, k.value},
+          meter_at(slot));
+    }
+}
+
+// above: helper classes to OWN many counters of some type
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter to put into the registry
+
+class OperationHoursMeter {                // as the strict one of Step-30
+public:
+    static constexpr std::size_t MAX_TEXT = 10 + 11;
+    void incr() noexcept;
+    void advance(std::uint64_t n) noexcept;
+    std::uint64_t get_ticks() const noexcept {
+        return (((days_ * 24ull + hours_) * 60 + minutes_) * 60 + seconds_) * 10
+             + sec_10th_;
+    }
+    std::size_t render(char* out) const noexcept;
+private:
+    std::uint32_t days_ = 0;
+    std::uint8_t hours_ = 0, minutes_ = 0, seconds_ = 0, sec_10th_ = 0;
+};
+
+void OperationHoursMeter::incr() noexcept {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    ++days_;
+}
+
+void OperationHoursMeter::advance(std::uint64_t n) noexcept {
+    auto const total = get_ticks() + n;
+    auto const in_day = unsigned(total % (24*60*60*10));
+    days_ = std::uint32_t(total / (24*60*60*10));
+    hours_ = std::uint8_t(in_day / (60*60*10));
+    minutes_ = std::uint8_t(in_day / (60*10) % 60);
+    seconds_ = std::uint8_t(in_day / 10 % 60);
+    sec_10th_ = std::uint8_t(in_day % 10);
+}
+
+std::size_t OperationHoursMeter::render(char* out) const noexcept {
+    char digits[10];
+    auto days = days_;
+    int n = 0;
+    do { digits[n++] = char('0' + days % 10); days /= 10; } while (days);
+    char* p = out;
+    while (n > 0) *p++ = digits[--n];
+    auto two = [&p](unsigned v) {
+        *p++ = char('0' + v / 10);
+        *p++ = char('0' + v % 10);
+    };
+    *p++ = 'd';
+    two(hours_);
+    *p++ = ':';
+    two(minutes_);
+    *p++ = ':';
+    two(seconds_);
+    *p++ = '.';
+    *p++ = char('0' + sec_10th_);
+    return std::size_t(p - out);
+}
+
+#include <charconv>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using Registry = MeterRegistry<OperationHoursMeter>;
+
+// writes "press-<n>" into `buffer`
+std::string_view press_name(std::uint64_t n, char (&buffer)[32]) {
+    std::memcpy(buffer, "press-", 6);
+    auto const end = std::to_chars(buffer + 6, buffer + sizeof buffer, n).ptr;
+    return {buffer, std::size_t(end - buffer)};
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void test_registry() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Registry registry{};
+    auto press = registry.get("press-1");
+    auto const by_id = registry.get(std::uint64_t{1});
+    char buffer[32];
+    for (std::uint64_t i = 2; i < 200'000; ++i)     // grows a few times
+        registry.get(press_name(i, buffer))->advance(i);
+    for (int i = 0; i < 36'000; ++i) press->incr();  // handle still valid
+    by_id->advance(42);
+    unsigned errors = (registry.find("press-1") != &*press)
+                    + (registry.find(std::uint64_t{1}) != &*by_id)
+                    + (registry.find("press-0") != nullptr)
+                    + (registry.find(std::uint64_t{2}) != nullptr)
+                    + (registry.get("press-1")->get_ticks() != 36'000);
+    for (std::uint64_t i = 2; i < 200'000; ++i) {
+        auto const* m = registry.find(press_name(i, buffer));
+        errors += (!m || m->get_ticks() != i);
+    }
+    std::size_t named = 0, numbered = 0;
+    registry.for_each([&](MeterKey const& key, OperationHoursMeter const&) {
+        ++(key.name.empty() ? numbered : named);
+    });
+    char text[OperationHoursMeter::MAX_TEXT];
+    std::cout << registry.size() << " meters (" << named << " by name, "
+              << numbered << " by id), press-1 at "
+              << std::string_view{text, press->render(text)} << ", "
+              << errors << " errors" << std::endl;
+}
+
+void benchmark_registry(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    {
+        auto start = std::chrono::steady_clock::now();
+        Registry registry{};
+        registry.reserve(n);
+        for (std::uint64_t id = 0; id < n; ++id) registry.get(id);
+        auto const create = seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        std::mt19937_64 rng{48};
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            found += (registry.find(rng() % (2 * n)) != nullptr);
+        auto const lookup = seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        std::uint64_t ticks = 0;
+        registry.for_each([&ticks](MeterKey const&, OperationHoursMeter& m) {
+            m.incr();
+            ticks += m.get_ticks();
+        });
+        std::cout << n << " meters by id: created in " << create
+                  << "s, " << n << " random lookups in " << lookup << "s ("
+                  << found << " found), ticking all in " << seconds_since(start)
+                  << "s" << std::endl;
+    }
+    {
+        auto const start = std::chrono::steady_clock::now();
+        Registry registry{};
+        registry.reserve(n);
+        char buffer[32];
+        for (std::uint64_t i = 0; i < n; ++i) registry.get(press_name(i, buffer));
+        std::cout << n << " meters by name: created in "
+                  << seconds_since(start) << "s" << std::endl;
+    }
+    {
+        // the straightforward way, with the same number of meters
+        auto const start = std::chrono::steady_clock::now();
+        std::unordered_map<std::string, std::unique_ptr<OperationHoursMeter>> map{};
+        map.reserve(n);
+        char buffer[32];
+        for (std::uint64_t i = 0; i < n; ++i)
+            map.emplace(press_name(i, buffer), std::make_unique<OperationHoursMeter>());
+        std::cout << n << " meters by name in an unordered_map<string,"
+                     " unique_ptr>: created in " << seconds_since(start)
+                  << "s" << std::endl;
+    }
+}
+
+int main() {
+    test_registry();
+    benchmark_registry(10'000'000);
+}
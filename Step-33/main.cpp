@@ -0,0 +1,819 @@
+/*
+ * ===============================================================
+ * Incremental OpenMetrics Export of Many Meters
+ * ===============================================================
+ * The registry of Step-32 owns millions of meters, but they can
+ * only be printed as `NdHH:MM:SS.t`, which monitoring systems do
+ * not understand. Here an `OpenMetricsExporter` writes all meters
+ * of a registry in the OpenMetrics (Prometheus) text format, ie.
+ * as a counter of seconds and optionally a gauge per stage:
+ *
+ *   registry           exporter                  body_ (scraped)
+ *   +----+----+---     +---------------------+   +------------------+
+ *   | m0 | m1 | ...    | ticks_  (as last    |   | # TYPE ...       |
+ *   +----+----+---     |          rendered)  |   | ..._total{..} 1.5|
+ *     |    |  compare  | counters_ (a fixed  |   | ..._total{..} 0.3|
+ *     +----+---------->|  size slot of text  |-->| ...              |
+ *     get_ticks()      |  per meter)         |   | # EOF            |
+ *                      | stages_   (ditto)   |   +------------------+
+ *                      +---------------------+
+ *
+ * On a scrape only the meters whose ticks changed since the prior
+ * scrape are rendered again, each into its own slot. If no line
+ * changed its length, the new text is also copied over the old one
+ * in the output, otherwise the output is assembled again by copying
+ * all slots (still without any formatting). To make that rare, the
+ * value of a limited stage is padded with zeros to the width of its
+ * limit, so only the seconds or days gaining a digit change a
+ * length. Numbers are written by `std::to_chars` into space reserved
+ * in advance, so a scrape does not allocate once all meters have
+ * been seen.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+struct MeterKey {
+    std::string_view name;            // empty if created by id
+    std::uint64_t id;
+};
+
+template<typename Meter>
+class MeterRegistry {
+public:
+    static constexpr std::size_t BLOCK = std::size_t{1} << 16;     // meters
+    static constexpr std::size_t NAME_BLOCK = std::size_t{1} << 20; // chars
+    class Handle {
+    public:
+        Meter& operator*() const { return *meter_; }
+        Meter* operator->() const { return meter_; }
+    private:
+        friend class MeterRegistry;
+        explicit Handle(Meter* meter) : meter_{meter} {}
+        Meter* meter_;
+    };
+    // the meter of this name or id, created if not yet there
+    Handle get(std::string_view name);
+    Handle get(std::uint64_t id);
+    // null if there is no such meter
+    Meter* find(std::string_view name) const;
+    Meter* find(std::uint64_t id) const;
+    void reserve(std::size_t meters);
+    std::size_t size() const { return size_; }
+    // calls `f(MeterKey, Meter&)` in the order of creation
+    template<typename F>
+    void for_each(F f);
+    template<typename F>
+    void for_each(F f) const;
+private:
+    struct Key {
+        std::uint64_t value;          // the id, or the name's offset
+        std::uint32_t length;         // 0 for an id
+    };
+    static std::uint64_t mix(std::uint64_t h) {
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        return h ^ (h >> 33);
+    }
+    static std::uint64_t hash(std::string_view name) {
+        std::uint64_t h = 0xcbf29ce484222325ull;          // FNV-1a
+        for (char c : name) h = (h ^ std::uint8_t(c)) * 0x100000001b3ull;
+        return mix(h);
+    }
+    static std::uint64_t hash(std::uint64_t id) { return mix(id ^ 0x9e3779b97f4a7c15ull); }
+    std::string_view name_of(Key const& k) const {
+        return {&names_[k.value / NAME_BLOCK][k.value % NAME_BLOCK], k.length};
+    }
+    Key& key_at(std::size_t slot) { return keys_[slot / BLOCK][slot % BLOCK]; }
+    Key const& key_at(std::size_t slot) const { return keys_[slot / BLOCK][slot % BLOCK]; }
+    Meter& meter_at(std::size_t slot) const { return meters_[slot / BLOCK][slot % BLOCK]; }
+    std::uint64_t hash_of(Key const& k) const {
+        return k.length ? hash(name_of(k)) : hash(k.value);
+    }
+    // the slot of an existing key or SIZE_MAX; `pos` is where to
+    // insert if not found
+    template<typename Equal>
+    std::size_t lookup(std::uint64_t h, Equal equal, std::size_t& pos) const;
+    std::size_t new_slot(Key const& k, std::uint64_t h, std::size_t pos);
+    void rehash(std::size_t capacity);
+    std::uint64_t store_name(std::string_view name);
+    std::vector<std::unique_ptr<Meter[]>> meters_{};
+    std::vector<std::unique_ptr<Key[]>> keys_{};
+    std::vector<std::unique_ptr<char[]>> names_{};
+    std::size_t names_used_ = NAME_BLOCK;      // in the last block
+    std::vector<std::uint64_t> index_ = std::vector<std::uint64_t>(16);
+    std::size_t size_ = 0;
+};
+
+template<typename Meter>
+template<typename Equal>
+std::size_t MeterRegistry<Meter>::lookup(std::uint64_t h, Equal equal,
+                                         std::size_t& pos) const {
+    auto const mask = index_.size() - 1;
+    auto const tag = h >> 32;
+    for (pos = h & mask; index_[pos] != 0; pos = (pos + 1) & mask)
+        if ((index_[pos] >> 32) == tag) {
+            auto const slot = std::size_t(index_[pos] & 0xffff'ffff) - 1;
+            if (equal(key_at(slot))) return slot;
+        }
+    return SIZE_MAX;
+}
+
+template<typename Meter>
+std::uint64_t MeterRegistry<Meter>::store_name(std::string_view name) {
+    if (name.size() > NAME_BLOCK)
+        throw std::invalid_argument{"meter name too long"};
+    if (NAME_BLOCK - names_used_ < name.size()) {
+        names_.emplace_back(new char[NAME_BLOCK]);
+        names_used_ = 0;
+    }
+    std::memcpy(&names_.back()[names_used_], name.data(), name.size());
+    auto const offset = (names_.size() - 1) * NAME_BLOCK + names_used_;
+    names_used_ += name.size();
+    return offset;
+}
+
+template<typename Meter>
+std::size_t MeterRegistry<Meter>::new_slot(Key const& k, std::uint64_t h,
+                                           std::size_t pos) {
+    if ((size_ + 1) * 4 > index_.size() * 3) {         // load <= 75%
+        rehash(index_.size() * 2);
+        for (pos = h & (index_.size() - 1); index_[pos] != 0;
+             pos = (pos + 1) & (index_.size() - 1)) {}
+    }
+    if (size_ % BLOCK == 0) {
+        // default (not value) initialized: keys are written before use
+        meters_.emplace_back(new Meter[BLOCK]);
+        keys_.emplace_back(new Key[BLOCK]);
+    }
+    auto const slot = size_++;
+    key_at(slot) = k;
+    index_[pos] = (h >> 32 << 32) | (slot + 1);
+    return slot;
+}
+
+template<typename Meter>
+void MeterRegistry<Meter>::rehash(std::size_t capacity) {
+    std::vector<std::uint64_t> index(capacity);
+    auto const mask = capacity - 1;
+    for (std::size_t slot = 0; slot < size_; ++slot) {
+        auto const h = hash_of(key_at(slot));
+        auto pos = h & mask;
+        while (index[pos] != 0) pos = (pos + 1) & mask;
+        index[pos] = (h >> 32 << 32) | (slot + 1);
+    }
+    index_.swap(index);
+}
+
+template<typename Meter>
+void MeterRegistry<Meter>::reserve(std::size_t meters) {
+    std::size_t capacity = index_.size();
+    while (meters * 4 > capacity * 3) capacity *= 2;
+    if (capacity > index_.size()) rehash(capacity);
+    meters_.reserve((meters + BLOCK - 1) / BLOCK);
+    keys_.reserve((meters + BLOCK - 1) / BLOCK);
+}
+
+template<typename Meter>
+auto MeterRegistry<Meter>::get(std::string_view name) -> Handle {
+    if (name.empty()) throw std::invalid_argument{"empty meter name"};
+    auto const h = hash(name);
+    std::size_t pos;
+    auto slot = lookup(h, [&](Key const& k) {
+        return k.length == name.size() && name_of(k) == name;
+    }, pos);
+    if (slot == SIZE_MAX) {
+        Key const k{store_name(name), std::uint32_t(name.size())};
+        slot = new_slot(k, h, pos);
+    }
+    return Handle{&meter_at(slot)};
+}
+
+template<typename Meter>
+auto MeterRegistry<Meter>::get(std::uint64_t id) -> Handle {
+    auto const h = hash(id);
+    std::size_t pos;
+    auto slot = lookup(h, [id](Key const& k) {
+        return k.length == 0 && k.value == id;
+    }, pos);
+    if (slot == SIZE_MAX) slot = new_slot(Key{id, 0}, h, pos);
+    return Handle{&meter_at(slot)};
+}
+
+template<typename Meter>
+Meter* MeterRegistry<Meter>::find(std::string_view name) const {
+    std::size_t pos;
+    auto const slot = lookup(hash(name), [&](Key const& k) {
+        return k.length == name.size() && name_of(k) == name;
+    }, pos);
+    return slot == SIZE_MAX ? nullptr : &meter_at(slot);
+}
+
+template<typename Meter>
+Meter* MeterRegistry<Meter>::find(std::uint64_t id) const {
+    std::size_t pos;
+    auto const slot = lookup(hash(id), [id](Key const& k) {
+        return k.length == 0 && k.value == id;
+    }, pos);
+    return slot == SIZE_MAX ? nullptr : &meter_at(slot);
+}
+
+template<typename Meter>
+template<typename F>
+void MeterRegistry<Meter>::for_each(F f) {
+    for (std::size_t slot = 0; slot < size_; ++slot) {
+        auto const& k = key_at(slot);
+        f(k.length ? MeterKey{name_of(k), 0} : MeterKey{{}, k.value},
+          meter_at(slot));
+    }
+}
+
+template<typename Meter>
+template<typename F>
+void MeterRegistry<Meter>::for_each(F f) const {
+    for (std::size_t slot = 0; slot < size_; ++slot) {
+        auto const& k = key_at(slot);
+        f(k.length ? MeterKey{name_of(k), 0} : MeterKey{{}, k.value},
+          static_cast<Meter const&>(meter_at(slot)));
+    }
+}
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// writes all of `iov[0..count)`, retrying after partial writes
+void write_all(int fd, iovec* iov, int count) {
+    while (count > 0) {
+        auto const written = ::writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error{errno, std::generic_category(), "writev"};
+        }
+        auto rest = std::size_t(written);
+        for (; count > 0 && rest >= iov->iov_len; ++iov, --count)
+            rest -= iov->iov_len;
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + rest;
+            iov->iov_len -= rest;
+        }
+    }
+}
+
+// Renders all meters of a registry in the OpenMetrics text format.
+// `Meter` must provide `get_ticks()`, `TICKS_PER_SECOND` (a power
+// of 10), the names of its `STAGES`, their `STAGE_LIMITS` (0 for
+// unlimited) and `get_stage(i)` for each of them. The stages are
+// assumed to follow from the ticks, so that a meter whose ticks did
+// not change need not be rendered again.
+template<typename Meter>
+class OpenMetricsExporter {
+public:
+    struct Options {
+        std::string family = "operation";  // + "_seconds", "_stage"
+        std::string help = "Operation hours of a meter.";
+        bool stages = false;                // also a gauge per stage
+    };
+    explicit OpenMetricsExporter(MeterRegistry<Meter> const& registry)
+        : OpenMetricsExporter{registry, Options{}} {}
+    OpenMetricsExporter(MeterRegistry<Meter> const& registry, Options options);
+    // the complete exposition, valid up to the next call
+    std::string_view scrape();
+    // writes a scrape to `path` via a temporary file and `rename`, so
+    // readers (eg. a textfile collector) never see a partial file
+    void write_file(std::string const& path);
+    // number of meters rendered by the last scrape
+    std::size_t get_rendered() const { return rendered_; }
+private:
+    static constexpr std::size_t VALUE_MAX = 20 + 1 + 19;   // "<s>.<frac>"
+    static constexpr std::uint64_t NEVER = ~std::uint64_t{0};
+    struct Line {
+        std::size_t text;              // offset of the slot in `text`
+        std::size_t body;              // offset in `body_`
+        std::size_t length;
+    };
+    struct Section {
+        std::string header;
+        std::vector<char> text{};
+        std::vector<Line> lines{};
+        std::size_t bytes = 0;         // sum of all line lengths
+    };
+    static constexpr int fraction_digits() {
+        int n = 0;
+        for (auto tps = Meter::TICKS_PER_SECOND; tps > 1; tps /= 10) ++n;
+        return n;
+    }
+    // digits of the largest value of stage `i`, 0 if unlimited
+    static constexpr int stage_width(std::size_t i) {
+        if (Meter::STAGE_LIMITS[i] == 0) return 0;
+        int n = 1;
+        for (auto v = Meter::STAGE_LIMITS[i] - 1; v >= 10; v /= 10) ++n;
+        return n;
+    }
+    static char* put(char* p, std::string_view s) {
+        std::memcpy(p, s.data(), s.size());
+        return p + s.size();
+    }
+    static std::size_t label_size(MeterKey const& key);
+    static char* put_label(char* p, MeterKey const& key);
+    static char* put_seconds(char* p, std::uint64_t ticks);
+    char* render_counter(char* p, MeterKey const& key, Meter const& m) const;
+    char* render_stages(char* p, MeterKey const& key, Meter const& m) const;
+    std::size_t counter_capacity(MeterKey const& key) const;
+    std::size_t stage_capacity(MeterKey const& key) const;
+    void add(MeterKey const& key);
+    void reserve_new();
+    template<typename Render>
+    void update(Section& section, std::size_t i, Render render);
+    void assemble();
+    MeterRegistry<Meter> const& registry_;
+    Options const options_;
+    Section counters_{};
+    Section stages_{};
+    std::vector<std::uint64_t> ticks_{};   // as last rendered
+    std::vector<char> body_{};
+    bool relayout_ = true;                 // a line changed its length
+    std::size_t rendered_ = 0;
+};
+
+template<typename Meter>
+OpenMetricsExporter<Meter>::OpenMetricsExporter(
+        MeterRegistry<Meter> const& registry, Options options)
+    : registry_{registry}, options_{std::move(options)}
+{
+    static_assert(fraction_digits() <= 19, "TICKS_PER_SECOND too large");
+    auto const& f = options_.family;
+    counters_.header = "# TYPE " + f + "_seconds counter\n"
+                       "# UNIT " + f + "_seconds seconds\n"
+                       "# HELP " + f + "_seconds " + options_.help + "\n";
+    stages_.header = "# TYPE " + f + "_stage gauge\n"
+                     "# HELP " + f + "_stage Value of each stage of a meter.\n";
+}
+
+template<typename Meter>
+std::size_t OpenMetricsExporter<Meter>::label_size(MeterKey const& key) {
+    if (key.name.empty()) return 5 + 20;              // id="<20 digits>"
+    auto n = std::size_t{8};                          // meter=""
+    for (char c : key.name)
+        n += (c == '\\' || c == '"' || c == '\n') ? 2 : 1;
+    return n;
+}
+
+template<typename Meter>
+char* OpenMetricsExporter<Meter>::put_label(char* p, MeterKey const& key) {
+    if (key.name.empty()) {
+        p = put(p, "id=\"");
+        p = std::to_chars(p, p + 20, key.id).ptr;
+        *p++ = '"';
+        return p;
+    }
+    p = put(p, "meter=\"");
+    for (char c : key.name)
+        switch (c) {
+        case '\\': *p++ = '\\'; *p++ = '\\'; break;
+        case '"':  *p++ = '\\'; *p++ = '"';  break;
+        case '\n': *p++ = '\\'; *p++ = 'n';  break;
+        default:   *p++ = c;
+        }
+    *p++ = '"';
+    return p;
+}
+
+template<typename Meter>
+char* OpenMetricsExporter<Meter>::put_seconds(char* p, std::uint64_t ticks) {
+    constexpr auto tps = std::uint64_t{Meter::TICKS_PER_SECOND};
+    p = std::to_chars(p, p + 20, ticks / tps).ptr;
+    *p++ = '.';                      // always a float, as "<s>.0" if
+    auto fraction = ticks % tps;     // the ticks are whole seconds
+    int n = fraction_digits();
+    if (n == 0) { *p++ = '0'; return p; }
+    for (int i = n; i-- > 0; fraction /= 10) p[i] = char('0' + fraction % 10);
+    return p + n;
+}
+
+template<typename Meter>
+char* OpenMetricsExporter<Meter>::render_counter(
+        char* p, MeterKey const& key, Meter const& m) const {
+    p = put(p, options_.family);
+    p = put(p, "_seconds_total{");
+    p = put_label(p, key);
+    p = put(p, "} ");
+    p = put_seconds(p, m.get_ticks());
+    *p++ = '\n';
+    return p;
+}
+
+template<typename Meter>
+char* OpenMetricsExporter<Meter>::render_stages(
+        char* p, MeterKey const& key, Meter const& m) const {
+    for (std::size_t i = 0; i < std::size(Meter::STAGES); ++i) {
+        p = put(p, options_.family);
+        p = put(p, "_stage{");
+        p = put_label(p, key);
+        p = put(p, ",stage=\"");
+        p = put(p, Meter::STAGES[i]);
+        p = put(p, "\"} ");
+        char digits[20];                 // "07" rather than "7", which
+        auto const n = std::to_chars(    // is allowed by the format
+            digits, digits + 20, std::uint64_t{m.get_stage(i)}).ptr - digits;
+        for (auto k = n; k < stage_width(i); ++k) *p++ = '0';
+        p = put(p, {digits, std::size_t(n)});
+        *p++ = '\n';
+    }
+    return p;
+}
+
+template<typename Meter>
+std::size_t OpenMetricsExporter<Meter>::counter_capacity(MeterKey const& key) const {
+    return options_.family.size() + 15 + label_size(key) + 2 + VALUE_MAX + 1;
+}
+
+template<typename Meter>
+std::size_t OpenMetricsExporter<Meter>::stage_capacity(MeterKey const& key) const {
+    std::size_t capacity = 0;
+    for (std::size_t i = 0; i < std::size(Meter::STAGES); ++i) {
+        auto const width = stage_width(i);
+        capacity += options_.family.size() + 7 + label_size(key) + 8
+                  + std::strlen(Meter::STAGES[i]) + 3
+                  + (width ? width : 20) + 1;
+    }
+    return capacity;
+}
+
+// reserves the text slots of a meter seen for the first time
+template<typename Meter>
+void OpenMetricsExporter<Meter>::add(MeterKey const& key) {
+    auto reserve = [](Section& s, std::size_t capacity) {
+        s.lines.push_back(Line{s.text.size(), 0, 0});
+        s.text.resize(s.text.size() + capacity);
+    };
+    reserve(counters_, counter_capacity(key));
+    if (options_.stages) reserve(stages_, stage_capacity(key));
+    ticks_.push_back(NEVER);
+    relayout_ = true;
+}
+
+// makes room for all meters added since the last scrape at once,
+// instead of growing (and copying) the slots meter by meter
+template<typename Meter>
+void OpenMetricsExporter<Meter>::reserve_new() {
+    std::size_t i = 0, counters = 0, stages = 0;
+    registry_.for_each([&](MeterKey const& key, Meter const&) {
+        if (i++ < ticks_.size()) return;
+        counters += counter_capacity(key);
+        if (options_.stages) stages += stage_capacity(key);
+    });
+    ticks_.reserve(registry_.size());
+    counters_.lines.reserve(registry_.size());
+    counters_.text.reserve(counters_.text.size() + counters);
+    if (options_.stages) {
+        stages_.lines.reserve(registry_.size());
+        stages_.text.reserve(stages_.text.size() + stages);
+    }
+}
+
+template<typename Meter>
+template<typename Render>
+void OpenMetricsExporter<Meter>::update(Section& section, std::size_t i,
+                                        Render render) {
+    auto& line = section.lines[i];
+    auto* const p = &section.text[line.text];
+    auto const length = std::size_t(render(p) - p);
+    if (length == line.length && !relayout_) {
+        std::memcpy(&body_[line.body], p, length);   // patch in place
+        return;
+    }
+    section.bytes = section.bytes - line.length + length;
+    line.length = length;
+    relayout_ = true;
+}
+
+template<typename Meter>
+void OpenMetricsExporter<Meter>::assemble() {
+    constexpr std::string_view eof = "# EOF\n";
+    auto size = counters_.header.size() + counters_.bytes + eof.size();
+    if (options_.stages) size += stages_.header.size() + stages_.bytes;
+    // room for the longest possible lines, so a later relayout only
+    // reallocates if meters were added
+    body_.reserve(counters_.header.size() + counters_.text.size()
+                  + stages_.header.size() + stages_.text.size() + eof.size());
+    body_.resize(size);
+    auto* p = body_.data();
+    auto copy = [&p, this](Section& s) {
+        p = put(p, s.header);
+        for (auto& line : s.lines) {
+            line.body = std::size_t(p - body_.data());
+            p = put(p, {&s.text[line.text], line.length});
+        }
+    };
+    copy(counters_);
+    if (options_.stages) copy(stages_);
+    put(p, eof);
+    relayout_ = false;
+}
+
+template<typename Meter>
+std::string_view OpenMetricsExporter<Meter>::scrape() {
+    if (registry_.size() > ticks_.size()) reserve_new();
+    rendered_ = 0;
+    std::size_t i = 0;
+    registry_.for_each([this, &i](MeterKey const& key, Meter const& m) {
+        if (i == ticks_.size()) add(key);
+        auto const ticks = m.get_ticks();
+        if (ticks != ticks_[i]) {
+            ticks_[i] = ticks;
+            update(counters_, i, [&](char* p) {
+                return render_counter(p, key, m);
+            });
+            if (options_.stages)
+                update(stages_, i, [&](char* p) {
+                    return render_stages(p, key, m);
+                });
+            ++rendered_;
+        }
+        ++i;
+    });
+    if (relayout_) assemble();
+    return {body_.data(), body_.size()};
+}
+
+template<typename Meter>
+void OpenMetricsExporter<Meter>::write_file(std::string const& path) {
+    auto const text = scrape();
+    auto const temp = path + ".tmp";
+    int const fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::system_error{errno, std::generic_category(), temp};
+    iovec iov{const_cast<char*>(text.data()), text.size()};
+    try { write_all(fd, &iov, 1); }
+    catch (...) { ::close(fd); std::remove(temp.c_str()); throw; }
+    ::close(fd);
+    if (std::rename(temp.c_str(), path.c_str()) != 0)
+        throw std::system_error{errno, std::generic_category(), path};
+}
+
+// above: helper classes to OWN and EXPORT many counters of some type
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter to put into the registry
+
+class OperationHoursMeter {                // as the one of Step-32
+public:
+    static constexpr unsigned TICKS_PER_SECOND = 10;
+    static constexpr char const* STAGES[] = {
+        "days", "hours", "minutes", "seconds", "sec_10th"
+    };
+    static constexpr unsigned STAGE_LIMITS[] = {0, 24, 60, 60, 10};
+    void incr() noexcept;
+    void advance(std::uint64_t n) noexcept;
+    std::uint64_t get_ticks() const noexcept {
+        return (((days_ * 24ull + hours_) * 60 + minutes_) * 60 + seconds_) * 10
+             + sec_10th_;
+    }
+    std::uint32_t get_stage(std::size_t i) const noexcept {
+        std::uint32_t const stages[] = {days_, hours_, minutes_, seconds_, sec_10th_};
+        return stages[i];
+    }
+private:
+    std::uint32_t days_ = 0;
+    std::uint8_t hours_ = 0, minutes_ = 0, seconds_ = 0, sec_10th_ = 0;
+};
+
+void OperationHoursMeter::incr() noexcept {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    ++days_;
+}
+
+void OperationHoursMeter::advance(std::uint64_t n) noexcept {
+    auto const total = get_ticks() + n;
+    auto const in_day = unsigned(total % (24*60*60*10));
+    days_ = std::uint32_t(total / (24*60*60*10));
+    hours_ = std::uint8_t(in_day / (60*60*10));
+    minutes_ = std::uint8_t(in_day / (60*10) % 60);
+    seconds_ = std::uint8_t(in_day / 10 % 60);
+    sec_10th_ = std::uint8_t(in_day % 10);
+}
+
+#include <atomic>
+#include <cstdlib>
+
+std::atomic<unsigned long long> allocations{0};
+
+void* operator new(std::size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc{};
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+
+using Registry = MeterRegistry<OperationHoursMeter>;
+using Exporter = OpenMetricsExporter<OperationHoursMeter>;
+
+// a stand-in for the HTTP endpoint scraped by the monitoring system:
+// answers ONE request read from `fd`, `GET /metrics` with a scrape
+void serve_metrics(int fd, Exporter& exporter) {
+    char request[4096];
+    std::size_t used = 0;
+    while (std::string_view{request, used}.find("\r\n\r\n") == std::string_view::npos) {
+        if (used == sizeof request) break;      // no end of header: 404
+        auto const n = ::read(fd, request + used, sizeof request - used);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += std::size_t(n);
+    }
+    constexpr std::string_view get = "GET /metrics ";
+    bool const found = std::string_view{request, used}.substr(0, get.size()) == get;
+    auto const body = found ? exporter.scrape() : std::string_view{"not found\n"};
+    char header[256];
+    char* p = header;
+    auto put = [&p](std::string_view s) { p = std::copy(s.begin(), s.end(), p); };
+    put(found ? "HTTP/1.1 200 OK\r\n"
+                "Content-Type: application/openmetrics-text;"
+                " version=1.0.0; charset=utf-8\r\n"
+              : "HTTP/1.1 404 Not Found\r\n"
+                "Content-Type: text/plain\r\n");
+    put("Content-Length: ");
+    p = std::to_chars(p, header + sizeof header, body.size()).ptr;
+    put("\r\nConnection: close\r\n\r\n");
+    iovec iov[] = {{header, std::size_t(p - header)},
+                   {const_cast<char*>(body.data()), body.size()}};
+    write_all(fd, iov, 2);
+}
+
+// sends `request` to `serve_metrics` over a socket pair and returns
+// the complete response
+std::string http_get(Exporter& exporter, std::string_view request) {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        throw std::system_error{errno, std::generic_category(), "socketpair"};
+    std::thread server{[fd = fds[1], &exporter]{
+        serve_metrics(fd, exporter);
+        ::close(fd);
+    }};
+    iovec iov{const_cast<char*>(request.data()), request.size()};
+    write_all(fds[0], &iov, 1);
+    std::string response{};
+    char buffer[64 * 1024];
+    for (ssize_t n; (n = ::read(fds[0], buffer, sizeof buffer)) != 0; )
+        if (n > 0) response.append(buffer, std::size_t(n));
+        else if (errno != EINTR) break;
+    server.join();
+    ::close(fds[0]);
+    return response;
+}
+
+// what the exporter should produce, the straightforward way
+std::string reference_exposition(Registry const& registry) {
+    std::ostringstream os{};
+    os << "# TYPE operation_seconds counter\n"
+          "# UNIT operation_seconds seconds\n"
+          "# HELP operation_seconds Operation hours of a meter.\n"
+       << std::fixed << std::setprecision(1);
+    registry.for_each([&os](MeterKey const& key, OperationHoursMeter const& m) {
+        os << "operation_seconds_total{";
+        if (key.name.empty())
+            os << "id=\"" << key.id << '"';
+        else
+            os << "meter=" << std::quoted(key.name);   // no newlines in names
+        os << "} " << m.get_ticks() / 10.0 << '\n';
+    });
+    os << "# EOF\n";
+    return os.str();
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// writes "press-<n>" into `buffer`
+std::string_view press_name(std::uint64_t n, char (&buffer)[32]) {
+    std::memcpy(buffer, "press-", 6);
+    auto const end = std::to_chars(buffer + 6, buffer + sizeof buffer, n).ptr;
+    return {buffer, std::size_t(end - buffer)};
+}
+
+void test_exporter() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Registry registry{};
+    auto press = registry.get("press-1");
+    auto lathe = registry.get("lathe \"B\\2\"");
+    auto const by_id = registry.get(std::uint64_t{7});
+    press->advance(99);
+    lathe->advance(36'000);
+    by_id->advance(24*60*60*10 + 1);
+    Exporter::Options options{};
+    options.stages = true;
+    Exporter exporter{registry, options};
+    std::cout << exporter.scrape();
+    press->incr();                  // 9.9 -> 10.0, a longer line
+    exporter.scrape();
+    auto const longer = exporter.get_rendered();
+    lathe->incr();
+    registry.get("mill-3")->advance(5);
+    exporter.scrape();
+    auto const added = exporter.get_rendered();
+    lathe->incr();                  // same length, patched in place
+    auto const patched = exporter.scrape();
+    auto const same_length = exporter.get_rendered();
+    Exporter fresh{registry, options};
+    std::cout << "rendered again: " << longer << " (longer), " << added
+              << " (with a new meter), " << same_length << " (same length), "
+              << patched.size() << " chars, identical to a full render: "
+              << std::boolalpha << (patched == fresh.scrape()) << std::endl;
+
+    Exporter plain{registry};
+    auto const ok = http_get(plain, "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    auto const missing = http_get(plain, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+    std::cout << "HTTP: " << ok.substr(0, ok.find('\r')) << " ("
+              << ok.size() - ok.find("\r\n\r\n") - 4 << " chars, "
+              << (ok.substr(ok.find("\r\n\r\n") + 4) == reference_exposition(registry)
+                  ? "as expected" : "DIFFERENT")
+              << "), " << missing.substr(0, missing.find('\r')) << std::endl;
+}
+
+void benchmark_scrape(std::size_t n) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Registry registry{};
+    registry.reserve(n);
+    std::mt19937_64 rng{49};
+    char buffer[32];
+    std::vector<OperationHoursMeter*> meters{};
+    meters.reserve(n);
+    for (std::uint64_t i = 0; i < n; ++i) {
+        auto m = registry.get(press_name(i, buffer));
+        m->advance(rng() % (24*60*60*10ull * 1000));
+        meters.push_back(&*m);
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto const reference = reference_exposition(registry);
+    std::cout << std::fixed << std::setprecision(3) << n
+              << " meters, full render with ostringstream: "
+              << seconds_since(start) << "s" << std::endl;
+    for (bool stages : {false, true}) {
+        Exporter::Options options{};
+        options.stages = stages;
+        Exporter exporter{registry, options};
+        start = std::chrono::steady_clock::now();
+        auto const size = exporter.scrape().size();
+        auto const first = seconds_since(start);
+        auto const same = !stages && exporter.scrape() == reference;
+        start = std::chrono::steady_clock::now();
+        exporter.scrape();
+        auto const unchanged = seconds_since(start);
+        double changed = 0;
+        auto const before = allocations.load();
+        for (int round = 0; round < 10; ++round) {
+            for (std::size_t i = 0; i < n / 100; ++i)
+                meters[rng() % n]->incr();
+            start = std::chrono::steady_clock::now();
+            exporter.scrape();
+            changed += seconds_since(start);
+        }
+        auto const allocs = allocations.load() - before;
+        std::cout << (stages ? "with stages: " : "seconds only: ") << size
+                  << " chars, first scrape " << first << "s"
+                  << (stages ? "" : same ? " (same text)" : " (DIFFERENT text)")
+                  << ", unchanged " << unchanged << "s, 1% changed "
+                  << changed / 10 << "s (" << exporter.get_rendered()
+                  << " rendered, " << allocs << " allocations)" << std::endl;
+        if (!stages) {
+            start = std::chrono::steady_clock::now();
+            exporter.write_file("meters.prom");
+            std::cout << "written to meters.prom in " << seconds_since(start)
+                      << "s" << std::endl;
+        }
+    }
+}
+
+int main() {
+    test_exporter();
+    benchmark_scrape(1'000'000);
+}
@@ -0,0 +1,388 @@
+/*
+ * ===============================================================
+ * Driving Many Differently Scheduled Meters from One Thread
+ * ===============================================================
+ * Up to now meters were ticked from a loop that sleeps between the
+ * ticks (like `test_hhmmss_chain` in Step-09), ie. one thread per
+ * schedule. Here a `TickDriver` keeps the next due time of MANY
+ * schedules (each with its own period and phase) in a heap and
+ * arms a single `timerfd` for the earliest of them, which is then
+ * waited for with `epoll` (together with an `eventfd` to stop):
+ *
+ *   schedules_                 heap_ (earliest first)
+ *   +------------------+       +-----------+
+ *   | 10ms  m0 m1 m2   |<------| t+3ms  #1 |---> timerfd (armed at
+ *   | 17ms  m3 m4      |<--+   | t+5ms  #0 |     the earliest time
+ *   | 100ms m5 ... m99 |   +---| t+5ms  #2 |     + slack) --> epoll
+ *   +------------------+       +-----------+          ^
+ *                                                     | eventfd
+ *                                                  stop()
+ *
+ * At each wakeup ALL schedules that are due are handled, each of
+ * them ticking all its meters in a batch. If a wakeup came late so
+ * that more than one period has passed, the missed ticks are made
+ * up in bulk with `advance(n)` and counted, instead of drifting.
+*/
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// `Meter` must provide `incr()` and `advance(n)`
+template<typename Meter>
+class TickDriver {
+public:
+    using Clock = std::chrono::steady_clock;   // CLOCK_MONOTONIC, as
+    using Duration = std::chrono::nanoseconds; // the timerfd below
+    struct Stats {
+        unsigned long long wakeups = 0;    // returns from epoll_wait
+        unsigned long long handled = 0;    // schedules due at a wakeup
+        unsigned long long ticks = 0;      // per schedule, not per meter
+        unsigned long long missed = 0;     // of those: made up in bulk
+    };
+    // wakeups may be delayed by up to `slack` to handle more
+    // schedules at once
+    explicit TickDriver(Duration slack = Duration{0});
+    TickDriver(TickDriver const&) =delete;
+    TickDriver& operator=(TickDriver const&) =delete;
+    ~TickDriver() { ::close(wakeup_); ::close(timer_); ::close(epoll_); }
+    // ticks at `phase + k * period` after the driver was created,
+    // starting with the first of these times still to come
+    std::size_t add_schedule(Duration period, Duration phase = Duration{0});
+    void attach(std::size_t schedule, Meter& meter) {
+        schedules_[schedule].meters.push_back(&meter);
+    }
+    // runs the loop in the calling thread up to `end` or `stop()`
+    void run_until(Clock::time_point end);
+    void stop();                               // from any thread
+    Clock::time_point get_epoch() const { return epoch_; }
+    Stats const& get_stats() const { return stats_; }
+    unsigned long long get_ticks(std::size_t schedule) const {
+        return schedules_[schedule].ticks;
+    }
+private:
+    struct Schedule {
+        Duration period;
+        std::vector<Meter*> meters{};
+        unsigned long long ticks = 0;
+    };
+    struct Due {
+        Clock::time_point when;
+        std::size_t schedule;
+        bool operator<(Due const& other) const {  // earliest at front
+            return when > other.when;
+        }
+    };
+    static int check(int result, char const* what) {
+        if (result < 0)
+            throw std::system_error{errno, std::generic_category(), what};
+        return result;
+    }
+    void arm(Clock::time_point when);
+    void handle(Clock::time_point now);
+    Clock::time_point const epoch_ = Clock::now();
+    Duration const slack_;
+    int epoll_ = -1, timer_ = -1, wakeup_ = -1;
+    std::vector<Schedule> schedules_{};
+    std::vector<Due> heap_{};
+    Stats stats_{};
+};
+
+template<typename Meter>
+TickDriver<Meter>::TickDriver(Duration slack)
+    : slack_{slack}
+{
+    try {
+        epoll_ = check(::epoll_create1(EPOLL_CLOEXEC), "epoll_create1");
+        timer_ = check(::timerfd_create(CLOCK_MONOTONIC,
+                                        TFD_NONBLOCK | TFD_CLOEXEC),
+                       "timerfd_create");
+        wakeup_ = check(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd");
+        for (int fd : {timer_, wakeup_}) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            check(::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event), "epoll_ctl");
+        }
+    }
+    catch (...) {
+        ::close(wakeup_); ::close(timer_); ::close(epoll_);
+        throw;
+    }
+}
+
+template<typename Meter>
+std::size_t TickDriver<Meter>::add_schedule(Duration period, Duration phase) {
+    if (period <= Duration{0})
+        throw std::invalid_argument{"period must be positive"};
+    auto const now = Clock::now();
+    auto first = epoch_ + phase;
+    if (first < now)
+        first += (now - first + period - Duration{1}) / period * period;
+    schedules_.push_back(Schedule{period});
+    heap_.push_back(Due{first, schedules_.size() - 1});
+    std::push_heap(heap_.begin(), heap_.end());
+    return schedules_.size() - 1;
+}
+
+template<typename Meter>
+void TickDriver<Meter>::arm(Clock::time_point when) {
+    auto const ns = std::chrono::duration_cast<Duration>(
+                        when.time_since_epoch()).count();
+    itimerspec spec{};
+    spec.it_value.tv_sec = ns / 1'000'000'000;
+    spec.it_value.tv_nsec = ns % 1'000'000'000;
+    if (ns <= 0) spec.it_value.tv_nsec = 1;    // zero would disarm
+    check(::timerfd_settime(timer_, TFD_TIMER_ABSTIME, &spec, nullptr),
+          "timerfd_settime");
+}
+
+// ticks all schedules due at `now`, each of them once per period
+// that has passed since it was due
+template<typename Meter>
+void TickDriver<Meter>::handle(Clock::time_point now) {
+    while (!heap_.empty() && heap_.front().when <= now) {
+        std::pop_heap(heap_.begin(), heap_.end());
+        auto& due = heap_.back();
+        auto& s = schedules_[due.schedule];
+        auto const n = std::uint64_t((now - due.when) / s.period) + 1;
+        if (n == 1)
+            for (auto* m : s.meters) m->incr();
+        else
+            for (auto* m : s.meters) m->advance(n);
+        s.ticks += n;
+        ++stats_.handled;
+        stats_.ticks += n;
+        stats_.missed += n - 1;
+        due.when += n * s.period;
+        std::push_heap(heap_.begin(), heap_.end());
+    }
+}
+
+template<typename Meter>
+void TickDriver<Meter>::run_until(Clock::time_point end) {
+    for (;;) {
+        auto const now = Clock::now();
+        handle(now);
+        if (now >= end) return;
+        auto next = end;
+        if (!heap_.empty()) next = std::min(end, heap_.front().when + slack_);
+        arm(next);
+        epoll_event events[2];
+        int const n = ::epoll_wait(epoll_, events, 2, -1);
+        if (n < 0 && errno == EINTR) continue;
+        check(n, "epoll_wait");
+        ++stats_.wakeups;
+        bool stopped = false;
+        for (int i = 0; i < n; ++i) {
+            std::uint64_t count;                     // just to reset
+            if (::read(events[i].data.fd, &count, sizeof count) < 0
+                    && errno != EAGAIN)
+                check(-1, "read");
+            stopped |= (events[i].data.fd == wakeup_);
+        }
+        if (stopped) return;
+    }
+}
+
+template<typename Meter>
+void TickDriver<Meter>::stop() {
+    std::uint64_t const one = 1;
+    check(int(::write(wakeup_, &one, sizeof one)), "write");
+}
+
+// above: helper class to DRIVE many counters of some type
+// ---------------------------------------------------------------
+// below: a SPECIFIC type of counter to be driven
+
+class OperationHoursMeter {                // as the one of Step-32
+public:
+    void incr() noexcept;
+    void advance(std::uint64_t n) noexcept;
+    std::uint64_t get_ticks() const noexcept {
+        return (((days_ * 24ull + hours_) * 60 + minutes_) * 60 + seconds_) * 10
+             + sec_10th_;
+    }
+private:
+    std::uint32_t days_ = 0;
+    std::uint8_t hours_ = 0, minutes_ = 0, seconds_ = 0, sec_10th_ = 0;
+};
+
+void OperationHoursMeter::incr() noexcept {
+    if (++sec_10th_ < 10) return;
+    sec_10th_ = 0;
+    if (++seconds_ < 60) return;
+    seconds_ = 0;
+    if (++minutes_ < 60) return;
+    minutes_ = 0;
+    if (++hours_ < 24) return;
+    hours_ = 0;
+    ++days_;
+}
+
+void OperationHoursMeter::advance(std::uint64_t n) noexcept {
+    auto const total = get_ticks() + n;
+    auto const in_day = unsigned(total % (24*60*60*10));
+    days_ = std::uint32_t(total / (24*60*60*10));
+    hours_ = std::uint8_t(in_day / (60*60*10));
+    minutes_ = std::uint8_t(in_day / (60*10) % 60);
+    seconds_ = std::uint8_t(in_day / 10 % 60);
+    sec_10th_ = std::uint8_t(in_day % 10);
+}
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+
+using Driver = TickDriver<OperationHoursMeter>;
+using namespace std::chrono_literals;
+
+// the number of times `phase + k * period` (k >= 0) lies in
+// [`from`, `to`], where all times are relative to the epoch
+unsigned long long expected_ticks(Driver::Duration from, Driver::Duration to,
+                                  Driver::Duration period, Driver::Duration phase) {
+    auto count = [&](Driver::Duration t) {        // those up to t
+        return t < phase ? 0ull : (unsigned long long)((t - phase) / period) + 1;
+    };
+    return count(to) - count(from - Driver::Duration{1});
+}
+
+void test_driver() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Driver driver{};
+    struct Setup { Driver::Duration period, phase; std::size_t meters; };
+    Setup const setups[] = {{10ms, 0ms, 3}, {17ms, 5ms, 2}, {100ms, 50ms, 20}};
+    std::vector<std::vector<OperationHoursMeter>> meters{};
+    for (auto const& s : setups) {
+        auto const id = driver.add_schedule(s.period, s.phase);
+        meters.emplace_back(s.meters);
+        for (auto& m : meters.back()) driver.attach(id, m);
+    }
+    auto const start = Driver::Clock::now() - driver.get_epoch();
+    driver.run_until(Driver::Clock::now() + 1s);
+    auto const end = Driver::Clock::now() - driver.get_epoch();
+    unsigned errors = 0;
+    for (std::size_t i = 0; i < std::size(setups); ++i) {
+        auto const ticks = driver.get_ticks(i);
+        for (auto const& m : meters[i]) errors += (m.get_ticks() != ticks);
+        // the last tick may have been due while returning
+        auto const expected = expected_ticks(start, end, setups[i].period,
+                                             setups[i].phase);
+        errors += (ticks + 1 < expected || ticks > expected);
+        std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         setups[i].period).count() << "ms: "
+                  << meters[i].size() << " meters at " << ticks << " ticks, ";
+    }
+    auto const& stats = driver.get_stats();
+    std::cout << stats.wakeups << " wakeups, " << stats.missed
+              << " ticks missed, " << errors << " errors" << std::endl;
+    std::thread stopper{[&driver]{
+        std::this_thread::sleep_for(100ms);
+        driver.stop();
+    }};
+    auto const wakeups = stats.wakeups;
+    driver.run_until(Driver::Clock::time_point::max());
+    stopper.join();
+    std::cout << "stopped from another thread after "
+              << stats.wakeups - wakeups << " more wakeups" << std::endl;
+}
+
+void test_catch_up() {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Driver driver{};
+    auto const id = driver.add_schedule(1ms);
+    std::vector<OperationHoursMeter> meters(10);
+    for (auto& m : meters) driver.attach(id, m);
+    auto const start = Driver::Clock::now() - driver.get_epoch();
+    driver.run_until(Driver::Clock::now() + 100ms);
+    auto const before = driver.get_stats().missed;
+    std::this_thread::sleep_for(50ms);      // eg. the process was stopped
+    driver.run_until(Driver::Clock::now() + 100ms);
+    auto const end = Driver::Clock::now() - driver.get_epoch();
+    auto const expected = expected_ticks(start, end, 1ms, 0ms);
+    auto const ticks = driver.get_ticks(id);
+    unsigned errors = (ticks + 1 < expected || ticks > expected);
+    for (auto const& m : meters) errors += (m.get_ticks() != ticks);
+    std::cout << ticks << " ticks (" << expected << " expected), "
+              << driver.get_stats().missed - before
+              << " made up after the pause, " << errors << " errors"
+              << std::endl;
+}
+
+double cpu_seconds() { return double(std::clock()) / CLOCKS_PER_SEC; }
+
+void benchmark_schedules(std::size_t schedules, std::size_t meters_each,
+                         Driver::Duration duration) {
+    std::cout << "== " << __func__ << " ==" << std::endl;
+    Driver::Duration const periods[] = {10ms, 20ms, 50ms, 100ms, 250ms};
+    std::mt19937 rng{50};
+    std::vector<std::pair<Driver::Duration, Driver::Duration>> setups{};
+    for (std::size_t i = 0; i < schedules; ++i) {
+        auto const period = periods[rng() % std::size(periods)];
+        setups.emplace_back(period, Driver::Duration{rng() % period.count()});
+    }
+    std::cout << schedules << " schedules with " << meters_each
+              << " meters each, for "
+              << std::chrono::duration<double>(duration).count() << "s\n";
+    for (auto slack : {0ms, 1ms}) {
+        Driver driver{slack};
+        std::vector<OperationHoursMeter> meters(schedules * meters_each);
+        for (std::size_t i = 0; i < schedules; ++i) {
+            auto const id = driver.add_schedule(setups[i].first, setups[i].second);
+            for (std::size_t j = 0; j < meters_each; ++j)
+                driver.attach(id, meters[i * meters_each + j]);
+        }
+        auto const cpu = cpu_seconds();
+        driver.run_until(Driver::Clock::now() + duration);
+        auto const& stats = driver.get_stats();
+        std::cout << "1 thread, slack " << slack.count() << "ms: "
+                  << stats.wakeups << " wakeups for " << stats.handled
+                  << " due schedules, " << stats.ticks << " ticks ("
+                  << stats.missed << " missed), CPU "
+                  << cpu_seconds() - cpu << "s" << std::endl;
+    }
+    {
+        std::vector<OperationHoursMeter> meters(schedules * meters_each);
+        std::vector<unsigned long long> missed(schedules);
+        auto const cpu = cpu_seconds();
+        auto const start = Driver::Clock::now();
+        auto const end = start + duration;
+        std::vector<std::thread> threads{};
+        for (std::size_t i = 0; i < schedules; ++i)
+            threads.emplace_back([&, i]{
+                auto const period = setups[i].first;
+                auto next = start + setups[i].second;
+                while (next <= end) {
+                    std::this_thread::sleep_until(next);
+                    auto const n = (Driver::Clock::now() - next) / period + 1;
+                    for (std::size_t j = 0; j < meters_each; ++j)
+                        meters[i * meters_each + j].advance(n);
+                    missed[i] += n - 1;
+                    next += n * period;
+                }
+            });
+        for (auto& t : threads) t.join();
+        unsigned long long all_missed = 0;
+        for (auto m : missed) all_missed += m;
+        std::cout << schedules << " threads: " << all_missed
+                  << " missed, CPU " << cpu_seconds() - cpu << "s" << std::endl;
+    }
+}
+
+int main() {
+    test_driver();
+    test_catch_up();
+    benchmark_schedules(2000, 10, 1s);
+}